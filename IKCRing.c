@@ -0,0 +1,130 @@
+/*
+ iOS Knob Control
+ Copyright (c) 2013-14, Jimmy Dee
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+
+#include "IKCRing.h"
+
+// M_PI is POSIX, not ISO C.
+static const double IKCRingPi = 3.14159265358979323846;
+
+void IKCRingLayout(const IKCRingGeometry* geometry, const IKCGlyphBitmap* titles, size_t count, IKCRingPlacement* placements)
+{
+    float const centerX = 0.5f * geometry->width;
+    float const centerY = 0.5f * geometry->height;
+
+    size_t j;
+    for (j=0; j<count; ++j) {
+        // the same placement IOSKnobControl uses for individual title layers
+        double position;
+        if (geometry->circular) {
+            position = (2.0*IKCRingPi/geometry->positions)*j;
+        }
+        else {
+            position = ((geometry->max-geometry->min)/geometry->positions)*(j+0.5) + geometry->min;
+        }
+
+        double actual = geometry->clockwise ? -position : position;
+        double radius = geometry->radius - 0.5*titles[j].height;
+
+        placements[j].x = centerX + radius*sin(actual);
+        placements[j].y = centerY - radius*cos(actual);
+        placements[j].angle = actual;
+    }
+}
+
+/*
+ * Bilinear sample of the title's coverage at (u, v), in source pixel index coordinates. Zero outside.
+ */
+static float sampleCoverage(const IKCGlyphBitmap* title, float u, float v)
+{
+    float const fu = floorf(u);
+    float const fv = floorf(v);
+    int const x0 = (int)fu;
+    int const y0 = (int)fv;
+    float const ax = u - fu;
+    float const ay = v - fv;
+
+    float c00 = 0.0f, c10 = 0.0f, c01 = 0.0f, c11 = 0.0f;
+    const uint8_t* row0 = title->alpha + (ptrdiff_t)y0 * (ptrdiff_t)title->stride;
+    const uint8_t* row1 = row0 + title->stride;
+
+    if (y0 >= 0 && y0 < title->height) {
+        if (x0 >= 0 && x0 < title->width) c00 = row0[x0];
+        if (x0+1 >= 0 && x0+1 < title->width) c10 = row0[x0+1];
+    }
+    if (y0+1 >= 0 && y0+1 < title->height) {
+        if (x0 >= 0 && x0 < title->width) c01 = row1[x0];
+        if (x0+1 >= 0 && x0+1 < title->width) c11 = row1[x0+1];
+    }
+
+    float const top = c00 + (c10 - c00) * ax;
+    float const bottom = c01 + (c11 - c01) * ax;
+    return top + (bottom - top) * ay;
+}
+
+void IKCRingComposite(uint8_t* ring, size_t stride, const IKCRingGeometry* geometry, const IKCGlyphBitmap* titles, const IKCRingPlacement* placements, size_t count)
+{
+    size_t j;
+    for (j=0; j<count; ++j) {
+        const IKCGlyphBitmap* title = &titles[j];
+        if (title->width <= 0 || title->height <= 0) continue;
+
+        float const c = cosf(placements[j].angle);
+        float const s = sinf(placements[j].angle);
+        float const halfWidth = 0.5f * title->width;
+        float const halfHeight = 0.5f * title->height;
+
+        // bounding box of the rotated title, clipped to the ring
+        float const extentX = fabsf(halfWidth * c) + fabsf(halfHeight * s) + 1.0f;
+        float const extentY = fabsf(halfWidth * s) + fabsf(halfHeight * c) + 1.0f;
+
+        int left = (int)floorf(placements[j].x - extentX);
+        int right = (int)ceilf(placements[j].x + extentX);
+        int top = (int)floorf(placements[j].y - extentY);
+        int bottom = (int)ceilf(placements[j].y + extentY);
+
+        if (left < 0) left = 0;
+        if (top < 0) top = 0;
+        if (right > geometry->width) right = geometry->width;
+        if (bottom > geometry->height) bottom = geometry->height;
+
+        int x, y;
+        for (y=top; y<bottom; ++y) {
+            uint8_t* row = ring + (size_t)y * stride;
+            float const dy = y + 0.5f - placements[j].y;
+
+            /*
+             * Inverse rotation from the ring back into the title: u = dx cos + dy sin, v = -dx sin + dy cos. Step it along the row
+             * instead of recomputing it per pixel.
+             */
+            float const dx = left + 0.5f - placements[j].x;
+            float u = dx * c + dy * s + halfWidth - 0.5f;
+            float v = -dx * s + dy * c + halfHeight - 0.5f;
+
+            for (x=left; x<right; ++x, u += c, v -= s) {
+                if (u <= -1.0f || v <= -1.0f || u >= title->width || v >= title->height) continue;
+
+                float const coverage = sampleCoverage(title, u, v);
+                if (coverage <= 0.0f) continue;
+
+                // source-over on coverage
+                float const existing = row[x];
+                row[x] = (uint8_t)(coverage + existing * (255.0f - coverage) / 255.0f + 0.5f);
+            }
+        }
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ iOS Knob Control
+ Copyright (c) 2013-14, Jimmy Dee
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef IKC_RING_H
+#define IKC_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Title ring. Optional. Composites the titles of a discrete knob into a single 8-bit coverage bitmap at their angles
+ * around the knob, so that the rotating layer holds one texture instead of one text layer per position. This only
+ * knows about coverage bitmaps, not fonts: the platform rasterizes each title (on iOS, with CoreText) and this does
+ * the layout and the compositing.
+ *
+ * All coordinates are in pixels, with the origin at the top left and y increasing downward. Rows of every bitmap are
+ * stored top to bottom. Angles are in radians, increasing clockwise on screen.
+ */
+
+/*
+ * A rasterized title: coverage in [0, 255]. A title with a width or height of 0 is skipped.
+ */
+typedef struct {
+    const uint8_t* alpha;
+    int width, height;
+    size_t stride;
+} IKCGlyphBitmap;
+
+/*
+ * Where a title goes: its center in the ring bitmap and its rotation about that center.
+ */
+typedef struct {
+    float x, y;
+    float angle;
+} IKCRingPlacement;
+
+/*
+ * Mirrors the knob control properties that determine where titles go.
+ */
+typedef struct {
+    /// size of the ring bitmap. the knob is centered in it.
+    int width, height;
+    /// distance from the center to the outer edge of each title (the knob radius)
+    float radius;
+    /// number of positions. title j goes at position j.
+    unsigned positions;
+    int circular, clockwise;
+    /// only used if circular is 0
+    float min, max;
+} IKCRingGeometry;
+
+/*
+ * Computes a placement for each of count titles, count <= positions.
+ */
+void IKCRingLayout(const IKCRingGeometry* geometry, const IKCGlyphBitmap* titles, size_t count, IKCRingPlacement* placements);
+
+/*
+ * Composites count titles at their placements into ring (geometry->width x geometry->height, stride bytes per row)
+ * using bilinear sampling and source-over. ring should be cleared first. Only the annulus the titles occupy is touched.
+ */
+void IKCRingComposite(uint8_t* ring, size_t stride, const IKCRingGeometry* geometry, const IKCGlyphBitmap* titles, const IKCRingPlacement* placements, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IKC_RING_H
@@ -0,0 +1,179 @@
+/*
+ iOS Knob Control
+ Copyright (c) 2013-14, Jimmy Dee
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "IKCShadow.h"
+
+#define IKC_SHADOW_PASSES 3
+
+// Transposes are done in tiles that fit comfortably in L1.
+#define IKC_SHADOW_TILE 32
+
+// Box sizes
+
+/*
+ * Radii of IKC_SHADOW_PASSES successive box blurs whose combined variance is as close as possible to sigma^2.
+ * After W. Jarosz, "Fast Image Convolutions": the first m boxes have width wl, the rest wl + 2.
+ */
+static void boxRadii(float sigma, int* radii)
+{
+    int const n = IKC_SHADOW_PASSES;
+    double wIdeal = sqrt(12.0 * sigma * sigma / n + 1.0);
+    int wl = (int)floor(wIdeal);
+    if (wl % 2 == 0) --wl;
+    int wu = wl + 2;
+
+    double mIdeal = (12.0 * sigma * sigma - n * wl * wl - 4.0 * n * wl - 3.0 * n) / (-4.0 * wl - 4.0);
+    int m = (int)round(mIdeal);
+
+    int j;
+    for (j=0; j<n; ++j) {
+        radii[j] = ((j < m ? wl : wu) - 1) / 2;
+    }
+}
+
+int IKCShadowPadding(float sigma)
+{
+    if (sigma <= 0.0f) return 0;
+
+    int radii[IKC_SHADOW_PASSES];
+    boxRadii(sigma, radii);
+
+    // the support of the combined kernel
+    int padding = 0;
+    int j;
+    for (j=0; j<IKC_SHADOW_PASSES; ++j) padding += radii[j];
+    return padding;
+}
+
+size_t IKCShadowScratchSize(int width, int height)
+{
+    if (width <= 0 || height <= 0) return 0;
+
+    // the running sums for the longer side, then two width x height planes to ping-pong between
+    int longer = width > height ? width : height;
+    return (size_t)longer * sizeof(uint32_t) + 2 * (size_t)width * (size_t)height;
+}
+
+// Passes
+
+/*
+ * One vertical box pass of the given radius over a width x height plane. Every column is independent, so each step is a
+ * loop over a whole row with no dependencies between elements.
+ */
+static void boxPassVertical(const uint8_t* restrict src, size_t srcStride, uint8_t* restrict dst, size_t dstStride, int width, int height, int radius, uint32_t* restrict sums)
+{
+    // 16.16 fixed point reciprocal of the box width. sum <= 255 * width, so sum * scale < 2^24.
+    uint32_t const scale = (uint32_t)(65536.0 / (2 * radius + 1) + 0.5);
+    int x, y;
+
+    memset(sums, 0, width * sizeof(uint32_t));
+
+    // rows 0..radius-1 are in the window for row 0. rows above 0 are 0.
+    for (y=0; y<radius && y<height; ++y) {
+        const uint8_t* row = src + y * srcStride;
+        for (x=0; x<width; ++x) sums[x] += row[x];
+    }
+
+    for (y=0; y<height; ++y) {
+        int const enter = y + radius;
+        int const leave = y - radius - 1;
+
+        if (enter < height) {
+            const uint8_t* row = src + enter * srcStride;
+            for (x=0; x<width; ++x) sums[x] += row[x];
+        }
+        if (leave >= 0) {
+            const uint8_t* row = src + leave * srcStride;
+            for (x=0; x<width; ++x) sums[x] -= row[x];
+        }
+
+        uint8_t* out = dst + y * dstStride;
+        for (x=0; x<width; ++x) {
+            out[x] = (uint8_t)((sums[x] * scale + 32768) >> 16);
+        }
+    }
+}
+
+static void transpose(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, int width, int height)
+{
+    int tx, ty, x, y;
+    for (ty=0; ty<height; ty+=IKC_SHADOW_TILE) {
+        int const yEnd = ty + IKC_SHADOW_TILE < height ? ty + IKC_SHADOW_TILE : height;
+        for (tx=0; tx<width; tx+=IKC_SHADOW_TILE) {
+            int const xEnd = tx + IKC_SHADOW_TILE < width ? tx + IKC_SHADOW_TILE : width;
+            for (y=ty; y<yEnd; ++y) {
+                for (x=tx; x<xEnd; ++x) {
+                    dst[x * dstStride + y] = src[y * srcStride + x];
+                }
+            }
+        }
+    }
+}
+
+/*
+ * IKC_SHADOW_PASSES vertical passes from src, leaving the result in a or b, whichever is returned.
+ */
+static uint8_t* boxBlurVertical(const uint8_t* src, size_t srcStride, uint8_t* a, uint8_t* b, int width, int height, const int* radii, uint32_t* sums)
+{
+    const uint8_t* in = src;
+    size_t inStride = srcStride;
+    uint8_t* out = a;
+
+    int j;
+    for (j=0; j<IKC_SHADOW_PASSES; ++j) {
+        boxPassVertical(in, inStride, out, width, width, height, radii[j], sums);
+        in = out;
+        inStride = width;
+        out = out == a ? b : a;
+    }
+
+    return (uint8_t*)in;
+}
+
+int IKCShadowBlur(uint8_t* alpha, int width, int height, size_t stride, float sigma, void* scratch)
+{
+    if (sigma <= 0.0f || width <= 0 || height <= 0) return 0;
+
+    void* allocated = NULL;
+    if (!scratch) {
+        scratch = allocated = malloc(IKCShadowScratchSize(width, height));
+        if (!scratch) return -1;
+    }
+
+    int const longer = width > height ? width : height;
+    uint32_t* sums = (uint32_t*)scratch;
+    uint8_t* a = (uint8_t*)(sums + longer);
+    uint8_t* b = a + (size_t)width * (size_t)height;
+
+    int radii[IKC_SHADOW_PASSES];
+    boxRadii(sigma, radii);
+
+    // vertical: alpha -> a or b
+    uint8_t* blurred = boxBlurVertical(alpha, stride, a, b, width, height, radii, sums);
+
+    // horizontal: transpose into the other plane, blur its columns, transpose back into alpha
+    uint8_t* other = blurred == a ? b : a;
+    transpose(blurred, width, other, height, width, height);
+    blurred = boxBlurVertical(other, height, blurred, other, height, width, radii, sums);
+    transpose(blurred, height, alpha, stride, height, width);
+
+    free(allocated);
+    return 0;
+}
@@ -0,0 +1,55 @@
+/*
+ iOS Knob Control
+ Copyright (c) 2013-14, Jimmy Dee
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef IKC_SHADOW_H
+#define IKC_SHADOW_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Shadow blur. Optional. Blurs an 8-bit coverage mask (the filled shadow path, or the alpha channel of an image) with
+ * three box passes in each direction, which is indistinguishable from a Gaussian at shadow sizes. Each pass runs down
+ * the columns of a whole row at a time, so the inner loops are plain element-wise arithmetic that the compiler
+ * vectorizes (NEON, SSE, AVX). Horizontal passes transpose the buffer and run the same vertical pass.
+ */
+
+/*
+ * Margin in pixels a mask needs around its content so the blur is not clipped, for a given sigma.
+ */
+int IKCShadowPadding(float sigma);
+
+/*
+ * Bytes of scratch memory IKCShadowBlur needs for a buffer of the given size.
+ */
+size_t IKCShadowScratchSize(int width, int height);
+
+/*
+ * Blurs the mask in place, approximating a Gaussian with standard deviation sigma, in pixels. Pixels outside the buffer
+ * count as 0. scratch must hold at least IKCShadowScratchSize(width, height) bytes, aligned as by malloc; if it is NULL,
+ * the function allocates and frees its own. Returns 0, or -1 if allocation failed. sigma <= 0 leaves the mask unchanged.
+ */
+int IKCShadowBlur(uint8_t* alpha, int width, int height, size_t stride, float sigma, void* scratch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IKC_SHADOW_H
@@ -0,0 +1,200 @@
+/*
+ iOS Knob Control
+ Copyright (c) 2013-14, Jimmy Dee
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "IKCTaper.h"
+
+#define IKC_TAPER_DEFAULT_EXPONENTIAL_SHAPE 4.0
+#define IKC_TAPER_DEFAULT_S_CURVE_SHAPE 2.0
+
+// Tapers
+
+/*
+ * The normalized curve, f(0) = 0, f(1) = 1, except for the logarithmic taper, which is not normalized.
+ */
+static double taperCurve(IKCTaperType type, double minimum, double maximum, double shape, double x)
+{
+    switch (type) {
+        case IKCTaperLogarithmic:
+            return minimum * pow(maximum / minimum, x);
+        case IKCTaperExponential:
+            return expm1(shape * x) / expm1(shape);
+        case IKCTaperSCurve:
+            if (x <= 0.0) return 0.0;
+            if (x >= 1.0) return 1.0;
+            return pow(x, shape) / (pow(x, shape) + pow(1.0 - x, shape));
+        default:
+            return x;
+    }
+}
+
+int IKCTaperInit(IKCTaperRef taper, IKCTaperType type, float minimum, float maximum, float shape)
+{
+    switch (type) {
+        case IKCTaperLinear:
+            break;
+        case IKCTaperLogarithmic:
+            if (minimum <= 0.0 || maximum <= 0.0) return -1;
+            break;
+        case IKCTaperExponential:
+            if (shape == 0.0) shape = IKC_TAPER_DEFAULT_EXPONENTIAL_SHAPE;
+            break;
+        case IKCTaperSCurve:
+            if (shape == 0.0) shape = IKC_TAPER_DEFAULT_S_CURVE_SHAPE;
+            if (shape < 0.0) return -1;
+            break;
+        default:
+            return -1;
+    }
+
+    taper->type = type;
+    taper->minimum = minimum;
+    taper->maximum = maximum;
+
+    int j;
+    for (j=0; j<=IKC_TAPER_TABLE_SIZE; ++j) {
+        double x = (double)j / IKC_TAPER_TABLE_SIZE;
+        double y = taperCurve(type, minimum, maximum, shape, x);
+        taper->table[j] = type == IKCTaperLogarithmic ? y : minimum + (maximum - minimum) * y;
+    }
+
+    return 0;
+}
+
+int IKCTaperInitWithBreakpoints(IKCTaperRef taper, const float* x, const float* y, size_t count)
+{
+    if (count < 2 || count > IKC_TAPER_MAX_BREAKPOINTS) return -1;
+    if (x[0] != 0.0 || x[count-1] != 1.0) return -1;
+
+    size_t k;
+    for (k=1; k<count; ++k) {
+        if (x[k] <= x[k-1]) return -1;
+    }
+
+    taper->type = IKCTaperBreakpoints;
+    taper->minimum = y[0];
+    taper->maximum = y[count-1];
+
+    int j;
+    k = 0;
+    for (j=0; j<=IKC_TAPER_TABLE_SIZE; ++j) {
+        double t = (double)j / IKC_TAPER_TABLE_SIZE;
+
+        // find the segment [x[k], x[k+1]] containing t. both march forward together.
+        while (k < count - 2 && t > x[k+1]) ++k;
+
+        double fraction = (t - x[k]) / (x[k+1] - x[k]);
+        taper->table[j] = y[k] + (y[k+1] - y[k]) * fraction;
+    }
+
+    return 0;
+}
+
+float IKCTaperEvaluate(const IKCTaper* taper, float x)
+{
+    // the negated comparison also catches NaN
+    if (!(x > 0.0f)) return taper->table[0];
+    if (x >= 1.0f) return taper->table[IKC_TAPER_TABLE_SIZE];
+
+    float scaled = x * IKC_TAPER_TABLE_SIZE;
+    int index = (int)scaled;
+    float fraction = scaled - index;
+
+    return taper->table[index] + (taper->table[index+1] - taper->table[index]) * fraction;
+}
+
+void IKCTaperEvaluateBuffer(const IKCTaper* taper, const float* x, float* values, size_t count)
+{
+    size_t j;
+    for (j=0; j<count; ++j) {
+        values[j] = IKCTaperEvaluate(taper, x[j]);
+    }
+}
+
+// Smoothing
+
+static uint32_t floatBits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float bitsFloat(uint32_t bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void IKCSmootherInit(IKCSmootherRef smoother, float initial, unsigned rampLength)
+{
+    __atomic_store_n(&smoother->targetBits, floatBits(initial), __ATOMIC_RELAXED);
+    smoother->current = smoother->target = initial;
+    smoother->increment = 0.0f;
+    smoother->remaining = 0;
+    smoother->rampLength = rampLength > 0 ? rampLength : 1;
+}
+
+/*
+ * The target is a single value with no other data published alongside it, so relaxed ordering is enough. The __atomic
+ * builtins (GCC and Clang) are used rather than _Atomic so that the header stays usable from C++ and Objective-C++.
+ */
+void IKCSmootherSetTarget(IKCSmootherRef smoother, float target)
+{
+    __atomic_store_n(&smoother->targetBits, floatBits(target), __ATOMIC_RELAXED);
+}
+
+void IKCSmootherProcess(IKCSmootherRef smoother, float* output, size_t frames)
+{
+    float target = bitsFloat(__atomic_load_n(&smoother->targetBits, __ATOMIC_RELAXED));
+    if (target != smoother->target) {
+        // start a new ramp from wherever we are now, even in the middle of the last one
+        smoother->target = target;
+        smoother->remaining = smoother->rampLength;
+        smoother->increment = (target - smoother->current) / smoother->rampLength;
+    }
+
+    size_t rampFrames = smoother->remaining < frames ? smoother->remaining : frames;
+    size_t j;
+
+    /*
+     * Both loops are free of loop-carried dependencies (each element is computed from j, not from the previous element),
+     * so the compiler vectorizes them.
+     */
+    float const start = smoother->current;
+    float const increment = smoother->increment;
+    for (j=0; j<rampFrames; ++j) {
+        output[j] = start + increment * (float)(j + 1);
+    }
+
+    smoother->remaining -= rampFrames;
+    if (smoother->remaining == 0) {
+        // land exactly on the target, without accumulated rounding error
+        smoother->current = target;
+        if (rampFrames > 0) output[rampFrames-1] = target;
+    }
+    else {
+        smoother->current = start + increment * (float)rampFrames;
+    }
+
+    float const current = smoother->current;
+    for (j=rampFrames; j<frames; ++j) {
+        output[j] = current;
+    }
+}
@@ -0,0 +1,117 @@
+/*
+ iOS Knob Control
+ Copyright (c) 2013-14, Jimmy Dee
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef IKC_TAPER_H
+#define IKC_TAPER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Value tapers and parameter smoothing. Optional. A taper maps a normalized knob position in [0, 1] to a value in
+ * [minimum, maximum] along a curve. Every curve is sampled once into a lookup table when the taper is initialized,
+ * so evaluation is one table lookup and a linear interpolation, whatever the curve. The smoother turns the stream
+ * of values coming from the knob into per-sample ramps for an audio buffer, so clients don't have to deal with
+ * zipper noise themselves.
+ *
+ * Neither one allocates. Both are plain structs that may live wherever the client likes, and evaluation and
+ * smoothing are safe to call from a real-time thread.
+ */
+
+// Intervals in the lookup table. The table has one more entry than this.
+#define IKC_TAPER_TABLE_SIZE 256
+
+// Maximum number of breakpoints accepted by IKCTaperInitWithBreakpoints.
+#define IKC_TAPER_MAX_BREAKPOINTS 64
+
+typedef enum {
+    /// value = minimum + (maximum - minimum) x
+    IKCTaperLinear,
+    /// Equal rotation gives equal ratios: value = minimum (maximum/minimum)^x. For frequencies. minimum and maximum must both be positive. shape is ignored.
+    IKCTaperLogarithmic,
+    /// Slow start, fast finish: value = minimum + (maximum - minimum) (e^(shape x) - 1)/(e^shape - 1). For gain. Default shape is 4.
+    IKCTaperExponential,
+    /// Slow at both ends, fast in the middle: value = minimum + (maximum - minimum) x^shape/(x^shape + (1-x)^shape). Default shape is 2.
+    IKCTaperSCurve,
+    /// Piecewise linear through user-supplied breakpoints. See IKCTaperInitWithBreakpoints.
+    IKCTaperBreakpoints
+} IKCTaperType;
+
+typedef struct {
+    IKCTaperType type;
+    float minimum, maximum;
+    float table[IKC_TAPER_TABLE_SIZE + 1];
+} IKCTaper;
+
+typedef IKCTaper* IKCTaperRef;
+
+/*
+ * Samples the curve into the lookup table. shape is only used by IKCTaperExponential and IKCTaperSCurve; pass 0 for the
+ * default. Returns 0, or -1 if the arguments are invalid (e.g., a logarithmic taper with a non-positive minimum, or
+ * IKCTaperBreakpoints, which requires IKCTaperInitWithBreakpoints).
+ */
+int IKCTaperInit(IKCTaperRef taper, IKCTaperType type, float minimum, float maximum, float shape);
+
+/*
+ * Samples a piecewise linear curve through count breakpoints (x[j], y[j]) into the lookup table. x must be strictly
+ * increasing, from 0 to 1 inclusive. 2 <= count <= IKC_TAPER_MAX_BREAKPOINTS. Returns 0, or -1 if the breakpoints are invalid.
+ */
+int IKCTaperInitWithBreakpoints(IKCTaperRef taper, const float* x, const float* y, size_t count);
+
+/*
+ * Evaluates the taper at x, which is clamped to [0, 1].
+ */
+float IKCTaperEvaluate(const IKCTaper* taper, float x);
+
+/*
+ * Evaluates the taper at each of count inputs.
+ */
+void IKCTaperEvaluateBuffer(const IKCTaper* taper, const float* x, float* values, size_t count);
+
+/*
+ * Linear-ramp parameter smoother. One thread (usually the main thread, in the knob's value-changed handler) sets
+ * the target. Another (usually the audio render thread) calls IKCSmootherProcess once per buffer. Each new target
+ * starts a ramp from the current value that takes rampLength frames.
+ */
+typedef struct {
+    uint32_t targetBits; // float bits. only accessed with relaxed atomic loads and stores, so the handoff is race-free and lock-free
+    float current, target, increment;
+    unsigned remaining, rampLength;
+} IKCSmoother;
+
+typedef IKCSmoother* IKCSmootherRef;
+
+void IKCSmootherInit(IKCSmootherRef smoother, float initial, unsigned rampLength);
+
+/*
+ * Sets a new target. Safe to call from any thread while another thread is in IKCSmootherProcess.
+ */
+void IKCSmootherSetTarget(IKCSmootherRef smoother, float target);
+
+/*
+ * Fills output with frames smoothed values. Real-time safe.
+ */
+void IKCSmootherProcess(IKCSmootherRef smoother, float* output, size_t frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IKC_TAPER_H
@@ -0,0 +1,457 @@
+/*
+ iOS Knob Control
+ Copyright (c) 2013-14, Jimmy Dee
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// clock_gettime, CLOCK_MONOTONIC, pthread_condattr_setclock and strdup are POSIX, not ISO C.
+#define _POSIX_C_SOURCE 200809L
+#ifdef __APPLE__
+// Darwin hides MSG_DONTWAIT and pthread_cond_timedwait_relative_np under strict POSIX.
+#define _DARWIN_C_SOURCE
+#endif // __APPLE__
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#endif // __APPLE__
+
+#include "IKCTelemetry.h"
+
+#define IKC_TELEMETRY_DEFAULT_FLUSH_INTERVAL_MS 10
+#define IKC_TELEMETRY_DEFAULT_CAPACITY 1024
+
+struct IKCTelemetryExporter {
+    int fd;
+    struct sockaddr_storage address;
+    socklen_t addressLength;
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+    int running, flushRequested;
+
+    // ring buffer of waiting samples
+    IKCTelemetrySample* samples;
+    unsigned capacity, head, count;
+
+    unsigned flushThreshold, flushIntervalMs;
+    uint64_t dropped;
+
+    // IKCTelemetryTimestamp when the oldest waiting sample was pushed
+    uint64_t oldestPushTime;
+};
+
+struct IKCTelemetryReceiver {
+    int fd;
+    char* path;
+};
+
+// Byte order
+
+static void put32(uint8_t* p, uint32_t value)
+{
+    p[0] = value >> 24;
+    p[1] = value >> 16;
+    p[2] = value >> 8;
+    p[3] = value;
+}
+
+static void put64(uint8_t* p, uint64_t value)
+{
+    put32(p, (uint32_t)(value >> 32));
+    put32(p + 4, (uint32_t)value);
+}
+
+static uint32_t get32(const uint8_t* p)
+{
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | (uint32_t)p[3];
+}
+
+static uint64_t get64(const uint8_t* p)
+{
+    return (uint64_t)get32(p) << 32 | get32(p + 4);
+}
+
+// Frames
+
+uint64_t IKCTelemetryTimestamp(void)
+{
+#ifdef __APPLE__
+    // clock_gettime is iOS 10+.
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0) mach_timebase_info(&timebase);
+    return mach_absolute_time() * timebase.numer / timebase.denom;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+#endif // __APPLE__
+}
+
+size_t IKCTelemetryEncodeFrame(const IKCTelemetrySample* samples, size_t count, uint8_t* buffer, size_t size)
+{
+    size_t length = IKC_TELEMETRY_HEADER_SIZE + count * IKC_TELEMETRY_SAMPLE_SIZE;
+    if (count > IKC_TELEMETRY_MAX_SAMPLES_PER_FRAME || length > size) return 0;
+
+    put32(buffer, IKC_TELEMETRY_MAGIC);
+    buffer[4] = IKC_TELEMETRY_VERSION;
+    buffer[5] = 0;
+    buffer[6] = count >> 8;
+    buffer[7] = count;
+
+    uint8_t* p = buffer + IKC_TELEMETRY_HEADER_SIZE;
+    size_t j;
+    for (j=0; j<count; ++j, p += IKC_TELEMETRY_SAMPLE_SIZE) {
+        uint32_t positionBits;
+        memcpy(&positionBits, &samples[j].position, sizeof(positionBits));
+
+        put32(p, samples[j].knobID);
+        put32(p + 4, positionBits);
+        put32(p + 8, (uint32_t)samples[j].positionIndex);
+        p[12] = samples[j].phase;
+        p[13] = p[14] = p[15] = 0;
+        put64(p + 16, samples[j].timestamp);
+    }
+
+    return length;
+}
+
+int IKCTelemetryDecodeFrame(const uint8_t* buffer, size_t size, IKCTelemetrySample* samples, size_t capacity)
+{
+    if (size < IKC_TELEMETRY_HEADER_SIZE) return -1;
+    if (get32(buffer) != IKC_TELEMETRY_MAGIC || buffer[4] != IKC_TELEMETRY_VERSION) return -1;
+
+    size_t count = (size_t)buffer[6] << 8 | buffer[7];
+    if (size < IKC_TELEMETRY_HEADER_SIZE + count * IKC_TELEMETRY_SAMPLE_SIZE) return -1;
+    if (count > capacity) count = capacity;
+
+    const uint8_t* p = buffer + IKC_TELEMETRY_HEADER_SIZE;
+    size_t j;
+    for (j=0; j<count; ++j, p += IKC_TELEMETRY_SAMPLE_SIZE) {
+        uint32_t positionBits = get32(p + 4);
+
+        samples[j].knobID = get32(p);
+        memcpy(&samples[j].position, &positionBits, sizeof(positionBits));
+        samples[j].positionIndex = (int32_t)get32(p + 8);
+        samples[j].phase = p[12];
+        samples[j].timestamp = get64(p + 16);
+    }
+
+    return (int)count;
+}
+
+// Sockets
+
+/*
+ * Fills in address from config. Returns the socket domain, or -1 if the config is unusable.
+ */
+static int telemetryAddress(const IKCTelemetryConfig* config, struct sockaddr_storage* address, socklen_t* addressLength)
+{
+    memset(address, 0, sizeof(*address));
+
+    if (config->transport == IKCTelemetryTransportUnix) {
+        struct sockaddr_un* un = (struct sockaddr_un*)address;
+        if (!config->path || strlen(config->path) >= sizeof(un->sun_path)) return -1;
+
+        un->sun_family = AF_UNIX;
+        strcpy(un->sun_path, config->path);
+        *addressLength = sizeof(*un);
+        return AF_UNIX;
+    }
+
+    // DEBT: IPv4 only, and numeric only. Resolving names doesn't belong on the path that creates a knob.
+    struct sockaddr_in* in = (struct sockaddr_in*)address;
+    in->sin_family = AF_INET;
+    in->sin_port = htons(config->port);
+    if (inet_pton(AF_INET, config->host ? config->host : "127.0.0.1", &in->sin_addr) != 1) return -1;
+
+    *addressLength = sizeof(*in);
+    return AF_INET;
+}
+
+// Exporter
+
+/*
+ * Sends everything waiting in the ring buffer, one frame at a time. Called with the mutex held. The mutex is released
+ * around each send so that pushes are never blocked on a syscall.
+ */
+static void exporterDrain(IKCTelemetryExporterRef exporter)
+{
+    IKCTelemetrySample batch[IKC_TELEMETRY_MAX_SAMPLES_PER_FRAME];
+    uint8_t frame[IKC_TELEMETRY_MAX_FRAME_SIZE];
+
+    while (exporter->count > 0) {
+        unsigned count = exporter->count < IKC_TELEMETRY_MAX_SAMPLES_PER_FRAME ? exporter->count : IKC_TELEMETRY_MAX_SAMPLES_PER_FRAME;
+        unsigned j;
+        for (j=0; j<count; ++j) {
+            batch[j] = exporter->samples[(exporter->head + j) % exporter->capacity];
+        }
+        exporter->head = (exporter->head + count) % exporter->capacity;
+        exporter->count -= count;
+
+        pthread_mutex_unlock(&exporter->mutex);
+
+        size_t length = IKCTelemetryEncodeFrame(batch, count, frame, sizeof(frame));
+        ssize_t sent = sendto(exporter->fd, frame, length, MSG_DONTWAIT, (struct sockaddr*)&exporter->address, exporter->addressLength);
+
+        pthread_mutex_lock(&exporter->mutex);
+
+        // there may be no one listening, or the receiver may be behind. drop the frame rather than stall.
+        if (sent < 0) exporter->dropped += count;
+    }
+}
+
+/*
+ * Waits on the monotonic clock until the given IKCTelemetryTimestamp. Called with the mutex held. Returns ETIMEDOUT once the
+ * time has passed.
+ */
+static int exporterWaitUntil(IKCTelemetryExporterRef exporter, uint64_t deadline)
+{
+    uint64_t now = IKCTelemetryTimestamp();
+    if (now >= deadline) return ETIMEDOUT;
+
+#ifdef __APPLE__
+    // no pthread_condattr_setclock on Darwin. a relative wait is unaffected by changes to the wall clock.
+    struct timespec interval;
+    interval.tv_sec = (deadline - now) / 1000000000ull;
+    interval.tv_nsec = (deadline - now) % 1000000000ull;
+    return pthread_cond_timedwait_relative_np(&exporter->condition, &exporter->mutex, &interval);
+#else
+    // the condition uses CLOCK_MONOTONIC, the same clock as IKCTelemetryTimestamp
+    struct timespec absolute;
+    absolute.tv_sec = deadline / 1000000000ull;
+    absolute.tv_nsec = deadline % 1000000000ull;
+    return pthread_cond_timedwait(&exporter->condition, &exporter->mutex, &absolute);
+#endif // __APPLE__
+}
+
+static void* exporterThread(void* context)
+{
+    IKCTelemetryExporterRef exporter = context;
+
+    pthread_mutex_lock(&exporter->mutex);
+    for (;;) {
+        /*
+         * Sleep indefinitely while there is nothing to send. Once a sample is waiting, sleep until it is flushIntervalMs old
+         * or the threshold is reached, whichever comes first.
+         */
+        while (exporter->running && exporter->count < exporter->flushThreshold && !exporter->flushRequested) {
+            if (exporter->count == 0) {
+                pthread_cond_wait(&exporter->condition, &exporter->mutex);
+            }
+            else if (exporterWaitUntil(exporter, exporter->oldestPushTime + exporter->flushIntervalMs * 1000000ull) == ETIMEDOUT) {
+                break;
+            }
+        }
+
+        exporterDrain(exporter);
+        exporter->flushRequested = 0;
+
+        if (!exporter->running) break;
+    }
+    pthread_mutex_unlock(&exporter->mutex);
+
+    return NULL;
+}
+
+IKCTelemetryExporterRef IKCTelemetryExporterCreate(const IKCTelemetryConfig* config)
+{
+    IKCTelemetryExporterRef exporter = calloc(1, sizeof(*exporter));
+    if (!exporter) return NULL;
+
+    int domain = telemetryAddress(config, &exporter->address, &exporter->addressLength);
+    if (domain < 0) {
+        free(exporter);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    exporter->capacity = config->capacity > 0 ? config->capacity : IKC_TELEMETRY_DEFAULT_CAPACITY;
+    exporter->flushIntervalMs = config->flushIntervalMs > 0 ? config->flushIntervalMs : IKC_TELEMETRY_DEFAULT_FLUSH_INTERVAL_MS;
+    exporter->flushThreshold = config->flushThreshold > 0 && config->flushThreshold < IKC_TELEMETRY_MAX_SAMPLES_PER_FRAME ? config->flushThreshold : IKC_TELEMETRY_MAX_SAMPLES_PER_FRAME;
+
+    exporter->samples = calloc(exporter->capacity, sizeof(IKCTelemetrySample));
+    exporter->fd = socket(domain, SOCK_DGRAM, 0);
+    if (!exporter->samples || exporter->fd < 0) {
+        int error = errno;
+        if (exporter->fd >= 0) close(exporter->fd);
+        free(exporter->samples);
+        free(exporter);
+        errno = error;
+        return NULL;
+    }
+
+    pthread_mutex_init(&exporter->mutex, NULL);
+#ifdef __APPLE__
+    pthread_cond_init(&exporter->condition, NULL);
+#else
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&exporter->condition, &attributes);
+    pthread_condattr_destroy(&attributes);
+#endif // __APPLE__
+    exporter->running = 1;
+
+    int error = pthread_create(&exporter->thread, NULL, exporterThread, exporter);
+    if (error) {
+        pthread_cond_destroy(&exporter->condition);
+        pthread_mutex_destroy(&exporter->mutex);
+        close(exporter->fd);
+        free(exporter->samples);
+        free(exporter);
+        errno = error;
+        return NULL;
+    }
+
+    return exporter;
+}
+
+int IKCTelemetryExporterPush(IKCTelemetryExporterRef exporter, const IKCTelemetrySample* sample)
+{
+    pthread_mutex_lock(&exporter->mutex);
+
+    if (exporter->count == exporter->capacity) {
+        ++ exporter->dropped;
+        pthread_mutex_unlock(&exporter->mutex);
+        return -1;
+    }
+
+    exporter->samples[(exporter->head + exporter->count) % exporter->capacity] = *sample;
+    ++ exporter->count;
+
+    if (exporter->count == 1) {
+        // the thread is waiting with no timeout. wake it up to start the interval.
+        exporter->oldestPushTime = IKCTelemetryTimestamp();
+        pthread_cond_signal(&exporter->condition);
+    }
+    else if (exporter->count == exporter->flushThreshold) {
+        pthread_cond_signal(&exporter->condition);
+    }
+
+    pthread_mutex_unlock(&exporter->mutex);
+    return 0;
+}
+
+void IKCTelemetryExporterFlush(IKCTelemetryExporterRef exporter)
+{
+    pthread_mutex_lock(&exporter->mutex);
+    exporter->flushRequested = 1;
+    pthread_cond_signal(&exporter->condition);
+    pthread_mutex_unlock(&exporter->mutex);
+}
+
+uint64_t IKCTelemetryExporterDroppedCount(IKCTelemetryExporterRef exporter)
+{
+    pthread_mutex_lock(&exporter->mutex);
+    uint64_t dropped = exporter->dropped;
+    pthread_mutex_unlock(&exporter->mutex);
+    return dropped;
+}
+
+void IKCTelemetryExporterRelease(IKCTelemetryExporterRef exporter)
+{
+    if (!exporter) return;
+
+    pthread_mutex_lock(&exporter->mutex);
+    exporter->running = 0;
+    pthread_cond_signal(&exporter->condition);
+    pthread_mutex_unlock(&exporter->mutex);
+
+    // the thread sends anything left before it exits
+    pthread_join(exporter->thread, NULL);
+
+    pthread_cond_destroy(&exporter->condition);
+    pthread_mutex_destroy(&exporter->mutex);
+    close(exporter->fd);
+    free(exporter->samples);
+    free(exporter);
+}
+
+// Receiver
+
+IKCTelemetryReceiverRef IKCTelemetryReceiverCreate(const IKCTelemetryConfig* config)
+{
+    struct sockaddr_storage address;
+    socklen_t addressLength;
+    int domain = telemetryAddress(config, &address, &addressLength);
+    if (domain < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    IKCTelemetryReceiverRef receiver = calloc(1, sizeof(*receiver));
+    if (!receiver) return NULL;
+
+    if (domain == AF_UNIX) {
+        receiver->path = strdup(config->path);
+        unlink(config->path);
+    }
+    else if (!config->host) {
+        // listen on all interfaces unless told otherwise
+        ((struct sockaddr_in*)&address)->sin_addr.s_addr = htonl(INADDR_ANY);
+    }
+
+    receiver->fd = socket(domain, SOCK_DGRAM, 0);
+    if (receiver->fd < 0 || bind(receiver->fd, (struct sockaddr*)&address, addressLength) < 0) {
+        int error = errno;
+        if (receiver->fd >= 0) close(receiver->fd);
+        free(receiver->path);
+        free(receiver);
+        errno = error;
+        return NULL;
+    }
+
+    return receiver;
+}
+
+int IKCTelemetryReceiverReceive(IKCTelemetryReceiverRef receiver, IKCTelemetrySample* samples, size_t capacity, int timeoutMs)
+{
+    struct pollfd pfd;
+    pfd.fd = receiver->fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    int ready = poll(&pfd, 1, timeoutMs);
+    if (ready <= 0) return ready;
+
+    uint8_t frame[IKC_TELEMETRY_MAX_FRAME_SIZE];
+    ssize_t length = recv(receiver->fd, frame, sizeof(frame), 0);
+    if (length < 0) return -1;
+
+    return IKCTelemetryDecodeFrame(frame, (size_t)length, samples, capacity);
+}
+
+void IKCTelemetryReceiverRelease(IKCTelemetryReceiverRef receiver)
+{
+    if (!receiver) return;
+
+    close(receiver->fd);
+    if (receiver->path) {
+        unlink(receiver->path);
+        free(receiver->path);
+    }
+    free(receiver);
+}
@@ -0,0 +1,166 @@
+/*
+ iOS Knob Control
+ Copyright (c) 2013-14, Jimmy Dee
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef IKC_TELEMETRY_H
+#define IKC_TELEMETRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Knob telemetry. Optional. Batches position samples from any number of knob controls into compact binary
+ * frames and sends them over a UDP or Unix-domain datagram socket from a background thread. The same
+ * files provide the matching decoder and receiver, so the receiving end (a desktop audio engine, a recorder,
+ * a test harness) can build them anywhere with BSD sockets and pthreads.
+ *
+ * Frame format. All fields are big-endian. One frame per datagram.
+ *
+ * Header (IKC_TELEMETRY_HEADER_SIZE bytes):
+ *   uint32   magic          IKC_TELEMETRY_MAGIC ("IKCT")
+ *   uint8    version        IKC_TELEMETRY_VERSION
+ *   uint8    reserved       0
+ *   uint16   count          number of samples that follow
+ *
+ * Sample (IKC_TELEMETRY_SAMPLE_SIZE bytes):
+ *   uint32   knobID
+ *   float32  position       IEEE 754 bits, radians
+ *   int32    positionIndex
+ *   uint8    phase          IKCTelemetryPhase
+ *   uint8[3] reserved       0
+ *   uint64   timestamp      monotonic, nanoseconds (see IKCTelemetryTimestamp)
+ */
+
+#define IKC_TELEMETRY_MAGIC 0x494b4354
+#define IKC_TELEMETRY_VERSION 1
+#define IKC_TELEMETRY_HEADER_SIZE 8
+#define IKC_TELEMETRY_SAMPLE_SIZE 24
+
+// Keeps every frame inside a single datagram on a standard 1500-byte MTU.
+#define IKC_TELEMETRY_MAX_FRAME_SIZE 1400
+#define IKC_TELEMETRY_MAX_SAMPLES_PER_FRAME ((IKC_TELEMETRY_MAX_FRAME_SIZE - IKC_TELEMETRY_HEADER_SIZE) / IKC_TELEMETRY_SAMPLE_SIZE)
+
+typedef enum {
+    /// Programmatic change, not the result of a gesture.
+    IKCTelemetryPhaseNone,
+    IKCTelemetryPhaseBegan,
+    IKCTelemetryPhaseChanged,
+    IKCTelemetryPhaseEnded,
+    IKCTelemetryPhaseCancelled
+} IKCTelemetryPhase;
+
+typedef enum {
+    IKCTelemetryTransportUDP,
+    IKCTelemetryTransportUnix
+} IKCTelemetryTransport;
+
+typedef struct {
+    uint32_t knobID;
+    float position;
+    int32_t positionIndex;
+    uint8_t phase;
+    uint64_t timestamp;
+} IKCTelemetrySample;
+
+/*
+ * Zero-initialize and fill in what you need. Zero fields take the defaults noted.
+ */
+typedef struct {
+    IKCTelemetryTransport transport;
+    /// UDP only. Numeric IPv4 address. Defaults to 127.0.0.1.
+    const char* host;
+    /// UDP only.
+    uint16_t port;
+    /// Unix-domain only. Path of the receiver's socket.
+    const char* path;
+    /// Exporter only. Maximum time a sample waits before being sent. Defaults to 10 ms.
+    unsigned flushIntervalMs;
+    /// Exporter only. Send as soon as this many samples are waiting. Defaults to, and is limited to, IKC_TELEMETRY_MAX_SAMPLES_PER_FRAME.
+    unsigned flushThreshold;
+    /// Exporter only. Samples buffered between flushes. Samples pushed when the buffer is full are dropped. Defaults to 1024.
+    unsigned capacity;
+} IKCTelemetryConfig;
+
+typedef struct IKCTelemetryExporter* IKCTelemetryExporterRef;
+typedef struct IKCTelemetryReceiver* IKCTelemetryReceiverRef;
+
+/*
+ * Monotonic clock in nanoseconds, for sample timestamps.
+ */
+uint64_t IKCTelemetryTimestamp(void);
+
+/*
+ * Encodes count samples (at most IKC_TELEMETRY_MAX_SAMPLES_PER_FRAME) into buffer. Returns the number of bytes written, or 0
+ * if the frame does not fit in size bytes.
+ */
+size_t IKCTelemetryEncodeFrame(const IKCTelemetrySample* samples, size_t count, uint8_t* buffer, size_t size);
+
+/*
+ * Decodes one frame into at most capacity samples. Returns the number of samples decoded, or -1 if the frame is malformed.
+ */
+int IKCTelemetryDecodeFrame(const uint8_t* buffer, size_t size, IKCTelemetrySample* samples, size_t capacity);
+
+/*
+ * Creates an exporter and starts its background thread. Returns NULL on failure (errno is set).
+ */
+IKCTelemetryExporterRef IKCTelemetryExporterCreate(const IKCTelemetryConfig* config);
+
+/*
+ * Queues a sample. Cheap enough for the main thread: no syscall, just a short critical section. Returns 0, or -1 if the buffer
+ * was full and the sample was dropped.
+ */
+int IKCTelemetryExporterPush(IKCTelemetryExporterRef exporter, const IKCTelemetrySample* sample);
+
+/*
+ * Asks the background thread to send whatever is waiting without waiting for the interval or the threshold.
+ */
+void IKCTelemetryExporterFlush(IKCTelemetryExporterRef exporter);
+
+/*
+ * Number of samples dropped because the buffer was full or a send failed.
+ */
+uint64_t IKCTelemetryExporterDroppedCount(IKCTelemetryExporterRef exporter);
+
+/*
+ * Sends anything still waiting, stops the background thread and frees the exporter.
+ */
+void IKCTelemetryExporterRelease(IKCTelemetryExporterRef exporter);
+
+/*
+ * Creates a receiver bound to the configured port or path. For Unix-domain sockets, any existing file at path is removed first.
+ * Returns NULL on failure (errno is set).
+ */
+IKCTelemetryReceiverRef IKCTelemetryReceiverCreate(const IKCTelemetryConfig* config);
+
+/*
+ * Waits up to timeoutMs (forever if negative) for a frame and decodes it into at most capacity samples. Returns the number of
+ * samples received, 0 on timeout, or -1 on error or a malformed frame.
+ */
+int IKCTelemetryReceiverReceive(IKCTelemetryReceiverRef receiver, IKCTelemetrySample* samples, size_t capacity, int timeoutMs);
+
+/*
+ * Closes the socket (removing the socket file for Unix-domain sockets) and frees the receiver.
+ */
+void IKCTelemetryReceiverRelease(IKCTelemetryReceiverRef receiver);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IKC_TELEMETRY_H
@@ -1,5 +1,22 @@
 #import <UIKit/UIKit.h>
 
+// Optional modules, each compiled in when its flag is defined. See Optional modules in README.md.
+#ifdef IKC_TELEMETRY
+#import "IKCTelemetry.h"
+#endif // IKC_TELEMETRY
+
+#ifdef IKC_TAPER
+#import "IKCTaper.h"
+#endif // IKC_TAPER
+
+#ifdef IKC_TITLE_RING
+#import "IKCRing.h"
+#endif // IKC_TITLE_RING
+
+#ifdef IKC_SHADOW_BITMAP
+#import "IKCShadow.h"
+#endif // IKC_SHADOW_BITMAP
+
 #if !__has_feature(objc_arc)
 #error IOSKnobControl requires automatic reference counting.
 #endif // objc_arc
@@ -55,6 +72,20 @@ typedef NS_ENUM(NSInteger, IKCGesture) {
     IKCGestureTap
 };
 
+/**
+ * One timestamped sample of a gesture, for followGestureSamples:count:state:. Which input field is used depends on the gesture property.
+ */
+typedef struct {
+    /// Time of the sample in seconds on the clock of UITouch timestamps and CACurrentMediaTime, e.g. the timestamp of a coalesced UITouch.
+    NSTimeInterval timestamp;
+    /// Location of the touch in the control's coordinate system. Used by IKCGestureOneFingerRotation and IKCGestureVerticalPan.
+    CGPoint location;
+    /// Rotation in radians since the gesture began, like the rotation property of UIRotationGestureRecognizer. Used by IKCGestureTwoFingerRotation.
+    CGFloat rotation;
+    /// Output. The position the knob took at this sample.
+    float position;
+} IKCGestureSample;
+
 #ifndef IKC_DISABLE_DEPRECATED
 /*
  * For brevity, the individual enumerated values were previously named IKCMLinearReturn, etc. But the longer names provide for better interoperability with Swift.
@@ -75,6 +106,8 @@ static const NSInteger IKCGVerticalPan DEPRECATED_MSG_ATTRIBUTE("Use IKCGestureV
 static const NSInteger IKCGTap DEPRECATED_MSG_ATTRIBUTE("Use IKCGestureTap instead") = IKCGestureTap;
 #endif // IKC_DISABLE_DEPRECATED
 
+@class IKCKnobConfiguration, IKCPreparedKnobConfiguration;
+
 /** iOS Knob Control
  * https://github.com/jdee/ios-knob-control
  *
@@ -160,11 +193,47 @@ static const NSInteger IKCGTap DEPRECATED_MSG_ATTRIBUTE("Use IKCGestureTap inste
  *
  * The image used will be [UIImage imageNamed:imageSetName]. The image will be selected appropriately for the screen density
  * from the image set named imageSetName in the application's asset catalog.
+ *
+ * The image is decoded on a background queue. Until it is ready, the knob is empty and casts no shadow.
+ * If image sets named imageSetName-highlighted, imageSetName-disabled or imageSetName-selected exist, they are used for
+ * those states, unless an image is set explicitly with setImage:forState:. Each of those is only decoded the first time the
+ * control needs it; until then, the normal image is used. Use prewarmImageSetsNamed:completion: to decode image sets in advance.
  * @param frame the initial frame for the control
  * @param imageSetName the name of an image set in the application's asset catalog
  */
 - (instancetype)initWithFrame:(CGRect)frame imageNamed:(NSString*)imageSetName;
 
+/**
+ * Decode image sets in advance
+ *
+ * Decodes the image sets with the specified names, and any -highlighted, -disabled and -selected variants, on a background queue,
+ * for use by initWithFrame:imageNamed:. A knob control created with a prewarmed image set shows its image immediately, with no
+ * placeholder. Call this during application launch for screens that create many knob controls. Decoded images are kept in a cache
+ * the system may purge under memory pressure. Call from the main thread.
+ * @param imageSetNames an array of names of image sets in the application's asset catalog
+ * @param completion called on the main thread when all the images are decoded; may be nil
+ */
++ (void)prewarmImageSetsNamed:(NSArray*)imageSetNames completion:(void(^)(void))completion;
+
+/**
+ * Discard decoded image sets
+ *
+ * Empties the cache filled by prewarmImageSetsNamed:completion: and initWithFrame:imageNamed:. Knob controls keep the images they already
+ * have. Image sets are decoded again the next time they are needed. Call from the main thread.
+ */
++ (void)clearImageCache;
+
+/**
+ * Generate shared paths in advance
+ *
+ * Generates the paths a knob control with the specified frame and mode and otherwise default settings would generate (see
+ * pathCacheHitRate), so that knob controls created later with the same geometry find them in the shared path cache. Call from
+ * the main thread.
+ * @param frame the frame of the knob controls to be created
+ * @param mode the mode of the knob controls to be created
+ */
++ (void)prewarmGeometryForFrame:(CGRect)frame mode:(IKCMode)mode;
+
 #pragma mark - Specifying knob control behavior
 
 /**
@@ -339,6 +408,17 @@ static const NSInteger IKCGTap DEPRECATED_MSG_ATTRIBUTE("Use IKCGestureTap inste
  */
 @property (nonatomic) BOOL masksImage;
 
+#ifdef IKC_TITLE_RING
+/** Render titles into a single ring texture
+ *
+ * Only applicable in IKCModeLinearReturn and IKCModeWheelOfFortune when no image is present. If set to YES, all titles are rendered at their angles
+ * into one bitmap on a background queue, instead of one text layer per position, so the rotating knob composites a single texture however many
+ * positions there are. If zoomTopTitle is YES, only the top title is drawn in a separate small layer. The titles appear when rendering finishes.
+ * Ignored if any title is an NSAttributedString. The default value is NO.
+ */
+@property (nonatomic) BOOL rendersTitleRing;
+#endif // IKC_TITLE_RING
+
 /** Titles for generated knob in discrete modes
  *
  * Only used when no image is provided in a discrete mode. These titles are rendered around the knob for each position index. If this property is nil (the default), the position
@@ -451,6 +531,91 @@ static const NSInteger IKCGTap DEPRECATED_MSG_ATTRIBUTE("Use IKCGestureTap inste
  */
 @property (nonatomic) CGFloat shadowRadius;
 
+#ifdef IKC_SHADOW_BITMAP
+/** Render shadows once into bitmaps
+ *
+ * If set to YES, instead of having Core Animation blur the knob and foreground shadows every frame, the control fills each shadow outline (the shadow
+ * path, or failing that the alpha channel of the knob or foreground image) and blurs it once on a background queue, in shadowColor at shadowOpacity,
+ * with a blur equivalent to shadowRadius. The bitmap is then simply displayed. The knob's shadow rotates with the knob, so non-symmetric knobs like
+ * the rotary dial and custom images without a shadow path get correct shadows as cheaply as circular ones. Bitmaps are shared by all knob controls
+ * with the same outline and shadow settings. A shadow appears when its bitmap is ready. If a bitmap can't be rendered, for lack of memory, the
+ * control falls back to the Core Animation shadow. The default value is NO.
+ */
+@property (nonatomic) BOOL rendersShadowBitmaps;
+#endif // IKC_SHADOW_BITMAP
+
+#pragma mark - Adapting rendering quality
+
+/**
+ * @name Adapting rendering quality
+ */
+
+/** Lower rendering quality under load while rotating
+ *
+ * If YES, while the knob follows a gesture, the control measures the frame time with a CADisplayLink. If the smoothed frame time exceeds
+ * degradedFrameTime, it lowers the rendering quality of the rotating knob until it comes to rest: the rotating shadow is drawn with
+ * degradedShadowRadius, and the knob, with any titles and mask, is rasterized at degradedRasterizationScale. When the gesture has ended
+ * and any return animation has finished, full quality is restored with a crossfade lasting qualityRestoreDuration. Default is NO.
+ */
+@property (nonatomic) BOOL adaptsRenderingQuality;
+
+/** Frame time threshold
+ *
+ * In seconds. Rendering quality is lowered when the smoothed frame time during a gesture exceeds this. Default is 1/45 s.
+ * @see adaptsRenderingQuality
+ */
+@property (nonatomic) NSTimeInterval degradedFrameTime;
+
+/** Shadow radius at lowered quality
+ *
+ * Used instead of shadowRadius, if smaller, while the rendering quality is lowered. Default is 1.
+ * @see adaptsRenderingQuality
+ */
+@property (nonatomic) CGFloat degradedShadowRadius;
+
+/** Rasterization scale at lowered quality
+ *
+ * Fraction of the screen scale at which the rotating knob is rasterized while the rendering quality is lowered. 0 disables rasterization.
+ * Default is 0.5.
+ * @see adaptsRenderingQuality
+ */
+@property (nonatomic) CGFloat degradedRasterizationScale;
+
+/** Duration of the crossfade back to full quality
+ *
+ * In seconds. Default is 0.2.
+ * @see adaptsRenderingQuality
+ */
+@property (nonatomic) NSTimeInterval qualityRestoreDuration;
+
+/** Whether rendering quality is currently lowered
+ *
+ * Key-value observable.
+ * @see adaptsRenderingQuality
+ */
+@property (nonatomic, readonly, getter=isRenderingDegraded) BOOL renderingDegraded;
+
+/** When the rendering quality was last lowered
+ *
+ * In the time base of CACurrentMediaTime(). 0 if it never has been.
+ */
+@property (nonatomic, readonly) CFTimeInterval lastDegradationStart;
+
+/** How long the rendering quality was lowered the last time
+ *
+ * In seconds. If the quality is currently lowered, the time since lastDegradationStart.
+ */
+@property (nonatomic, readonly) NSTimeInterval lastDegradationDuration;
+
+/** Total time spent at lowered quality
+ *
+ * In seconds, including any current period.
+ */
+@property (nonatomic, readonly) NSTimeInterval totalDegradationDuration;
+
+/** Number of times the rendering quality has been lowered */
+@property (nonatomic, readonly) NSUInteger degradationCount;
+
 #pragma mark - Accessing knob control state (position and index)
 
 /**
@@ -495,6 +660,25 @@ static const NSInteger IKCGTap DEPRECATED_MSG_ATTRIBUTE("Use IKCGestureTap inste
  */
 - (void)setPosition:(float)position animated:(BOOL)animated;
 
+#ifdef IKC_TAPER
+/** Value taper
+ *
+ * If set, the value property maps position through this taper, e.g. to a gain or a frequency. The control does not take ownership; the taper must
+ * outlive it. Default is NULL.
+ * @see value
+ */
+@property (nonatomic) IKCTaperRef taper;
+
+/** Tapered value of the current position
+ *
+ * The position, normalized to [0, 1], mapped through the taper property. If circular is NO, position is normalized over [min, max]. If circular is
+ * YES, position is first reduced to (-π, π] and then normalized over that interval, so that a position of 0 gives the value at the middle of the
+ * taper. If taper is NULL, returns the normalized position. Consult this property instead of position in a UIControlEventValueChanged handler to
+ * avoid evaluating the curve there. Not meaningful in IKCModeRotaryDial.
+ */
+@property (nonatomic, readonly) float value;
+#endif // IKC_TAPER
+
 #pragma mark - Getting current state
 
 /**
@@ -574,4 +758,265 @@ static const NSInteger IKCGTap DEPRECATED_MSG_ATTRIBUTE("Use IKCGestureTap inste
  */
 - (void)dialNumber:(int)number;
 
+#pragma mark - Following batched gesture samples
+
+/**
+ * @name Following batched gesture samples
+ */
+
+/** Follow a batch of gesture samples
+ *
+ * The built-in gesture recognizers deliver one touch location per callback. A client that receives several samples at once, for example from
+ * coalescedTouchesForTouch: on UIEvent in its own recognizer or touch handler, can pass them all here in one call. The samples are run through the
+ * same tracking as the built-in gesture, including the angle unwrapping of IKCGestureOneFingerRotation, in a tight loop, and the knob is only
+ * rotated to the position of the last sample. At most one UIControlEventValueChanged is generated per call. With a state of
+ * UIGestureRecognizerStateEnded or UIGestureRecognizerStateCancelled, the knob then snaps or dials as at the end of the built-in gesture.
+ *
+ * The position the knob took at each sample is written back to the position field of that sample, so the samples can be used afterward for velocity
+ * tracking or recording. They are also available through gestureSamples while the control's actions are sent. If there is a telemetryExporter, each
+ * sample is exported with its own timestamp.
+ *
+ * Pass UIGestureRecognizerStateBegan with the first batch of a gesture and UIGestureRecognizerStateChanged with the rest. count may be 0 only with
+ * UIGestureRecognizerStateEnded or UIGestureRecognizerStateCancelled. Ignored if the control is disabled or gesture is IKCGestureTap.
+ * @param samples the samples, in order, or NULL if count is 0
+ * @param count the number of samples
+ * @param state the phase of the gesture this batch belongs to
+ */
+- (void)followGestureSamples:(IKCGestureSample*)samples count:(NSUInteger)count state:(UIGestureRecognizerState)state;
+
+/** Samples of the batch being followed
+ *
+ * Only valid while the actions for the UIControlEventValueChanged generated by followGestureSamples:count:state: are being sent. Points to the
+ * samples passed to that method, with their position fields filled in. NULL at any other time.
+ * @see gestureSampleCount
+ */
+@property (nonatomic, readonly) const IKCGestureSample* gestureSamples;
+
+/** Number of samples in gestureSamples
+ *
+ * 0 whenever gestureSamples is NULL.
+ */
+@property (nonatomic, readonly) NSUInteger gestureSampleCount;
+
+#ifdef IKC_TELEMETRY
+#pragma mark - Exporting telemetry
+
+/**
+ * @name Exporting telemetry
+ */
+
+/** Telemetry exporter
+ *
+ * If set, a sample is queued on this exporter each time the knob follows a gesture, carrying telemetryID, position, positionIndex, the gesture phase
+ * and a monotonic timestamp. Changes made by the app through position, setPosition:animated:, positionIndex or dialNumber: are queued too, with
+ * IKCTelemetryPhaseNone. Samples from any number of knob controls sharing an exporter are batched into binary frames and sent over a datagram socket
+ * from a background thread. See IKCTelemetry.h for the frame format and the matching receiver. The control does not take ownership; the exporter must
+ * outlive it. Default is NULL.
+ */
+@property (nonatomic) IKCTelemetryExporterRef telemetryExporter;
+
+/** Telemetry knob ID
+ *
+ * Identifies this control in telemetry samples. Default is 0.
+ * @see telemetryExporter
+ */
+@property (nonatomic) uint32_t telemetryID;
+#endif // IKC_TELEMETRY
+
+#pragma mark - Caching generated paths
+
+/**
+ * @name Caching generated paths
+ */
+
+/** Hit rate of the shared path cache
+ *
+ * The paths the control generates (the knob circle, the pip in IKCModeContinuous, the rotary dial with its finger holes and the finger stop) depend only on
+ * the bounds of the control, knobRadius, fingerHoleRadius and fingerHoleMargin. They are generated once and shared, as immutable CGPaths, by all knob controls
+ * with the same geometry, for the knob image, the mask and the shadow. This method reports the fraction of path lookups that found a cached path since the
+ * last call to clearPathCache. Returns 0 if there have been no lookups.
+ * @return the hit rate of the shared path cache, in [0, 1]
+ */
++ (double)pathCacheHitRate;
+
+/** Clear the shared path cache
+ *
+ * Discards all cached paths and resets the hit rate. Paths will be regenerated on demand. The cache also discards its paths, but keeps counting, when
+ * the application receives a memory warning, and evicts the least recently used path when it is full. Call from the main thread.
+ */
++ (void)clearPathCache;
+
+#pragma mark - Applying prepared configurations
+
+/**
+ * @name Applying prepared configurations
+ */
+
+/** Snapshot of the current configuration
+ *
+ * Returns an immutable IKCKnobConfiguration with the current values of all the properties it covers. Use mutableCopy to derive a new configuration
+ * from it.
+ */
+@property (nonatomic, readonly) IKCKnobConfiguration* configuration;
+
+/** Apply a prepared configuration in one step
+ *
+ * Sets every property covered by the configuration and rebuilds the knob once, with animation disabled, using the paths, fitted font size and
+ * (with rendersTitleRing) title ring computed in advance by IKCKnobConfiguration. If the bounds of the control differ from the size the
+ * configuration was prepared for, anything that depends on the size, including a default knobRadius or fingerHoleMargin, is computed here as usual.
+ * Call from the main thread.
+ * @param prepared a configuration returned by prepareForSize:scale: or prepareForSize:completion:
+ * @see lastConfigurationApplyTime
+ */
+- (void)applyPreparedConfiguration:(IKCPreparedKnobConfiguration*)prepared;
+
+/** Main-thread time taken by the last applyPreparedConfiguration:
+ *
+ * In seconds. 0 if no configuration has been applied. Covers rebuilding the layer tree and drawing the title and dial number layers, which
+ * applyPreparedConfiguration: does before it returns. Compositing by the render server is not included.
+ */
+@property (nonatomic, readonly) NSTimeInterval lastConfigurationApplyTime;
+
+@end
+
+/** Immutable knob configuration
+ *
+ * A value type covering the properties of a knob control that determine what it draws: mode, positions, titles, range, colors, font, radii and shadow.
+ * Instances are immutable and may be used from any thread. Use IKCMutableKnobConfiguration to build one, or start from the configuration property of
+ * an existing control.
+ *
+ * Everything the control derives from a configuration can be computed in advance, away from the main thread, with prepareForSize:scale: or
+ * prepareForSize:completion:. The result is applied to a control with applyPreparedConfiguration:.
+ */
+@interface IKCKnobConfiguration : NSObject <NSCopying, NSMutableCopying>
+
+/** See IOSKnobControl.mode. Default is IKCModeLinearReturn. */
+@property (nonatomic, readonly) IKCMode mode;
+/** See IOSKnobControl.gesture. Default is IKCGestureOneFingerRotation. */
+@property (nonatomic, readonly) IKCGesture gesture;
+/** See IOSKnobControl.positions. Default is 2. */
+@property (nonatomic, readonly) NSUInteger positions;
+/** See IOSKnobControl.titles. Default is nil. */
+@property (nonatomic, readonly, copy) NSArray* titles;
+/** See IOSKnobControl.circular. Default is YES. */
+@property (nonatomic, readonly) BOOL circular;
+/** See IOSKnobControl.clockwise. Default is NO. */
+@property (nonatomic, readonly) BOOL clockwise;
+/** See IOSKnobControl.min. Default is just above -M_PI. */
+@property (nonatomic, readonly) float min;
+/** See IOSKnobControl.max. Default is just below M_PI. */
+@property (nonatomic, readonly) float max;
+/** See IOSKnobControl.fontName. Default is Helvetica. */
+@property (nonatomic, readonly, copy) NSString* fontName;
+/** See IOSKnobControl.zoomTopTitle. Default is YES. */
+@property (nonatomic, readonly) BOOL zoomTopTitle;
+/** See IOSKnobControl.zoomPointSize. Default is 0. */
+@property (nonatomic, readonly) CGFloat zoomPointSize;
+/** See IOSKnobControl.knobRadius. Negative means half the width of the size the configuration is prepared for, as for a new control. Default is -1. */
+@property (nonatomic, readonly) CGFloat knobRadius;
+/** See IOSKnobControl.fingerHoleRadius. Default is 22. */
+@property (nonatomic, readonly) CGFloat fingerHoleRadius;
+/** See IOSKnobControl.fingerHoleMargin. Negative means the default computed from knobRadius and fingerHoleRadius. Default is -1. */
+@property (nonatomic, readonly) CGFloat fingerHoleMargin;
+/** See IOSKnobControl.shadowColor. Default is black. */
+@property (nonatomic, readonly) UIColor* shadowColor;
+/** See IOSKnobControl.shadowOpacity. Default is 0. */
+@property (nonatomic, readonly) CGFloat shadowOpacity;
+/** See IOSKnobControl.shadowOffset. Default is (0, 3). */
+@property (nonatomic, readonly) CGSize shadowOffset;
+/** See IOSKnobControl.shadowRadius. Default is 3. */
+@property (nonatomic, readonly) CGFloat shadowRadius;
+#ifdef IKC_TITLE_RING
+/** See IOSKnobControl.rendersTitleRing. Default is NO. */
+@property (nonatomic, readonly) BOOL rendersTitleRing;
+#endif // IKC_TITLE_RING
+
+/** Fill color for a state
+ *
+ * Like IOSKnobControl's method, falls back to the color for UIControlStateNormal. Returns nil if neither was set, in which case the control derives
+ * the color from its tintColor.
+ */
+- (UIColor*)fillColorForState:(UIControlState)state;
+
+/** Title color for a state
+ *
+ * Like fillColorForState:.
+ */
+- (UIColor*)titleColorForState:(UIControlState)state;
+
+/** Prepare the configuration for a knob of a given size
+ *
+ * Resolves defaults, generates the knob paths, fits the font size for the titles and, with rendersTitleRing, renders the title ring. Safe to call
+ * on any thread. This is the expensive part of configuring a knob control.
+ * @param size the bounds size of the knob control that will apply the result
+ * @param scale the scale of the screen the control is on
+ * @return the prepared configuration, for applyPreparedConfiguration:
+ */
+- (IKCPreparedKnobConfiguration*)prepareForSize:(CGSize)size scale:(CGFloat)scale;
+
+/** Prepare the configuration on a background queue
+ *
+ * Calls prepareForSize:scale: with the scale of the main screen on a background queue. Call from the main thread.
+ * @param size the bounds size of the knob control that will apply the result
+ * @param completion called on the main thread with the prepared configuration
+ */
+- (void)prepareForSize:(CGSize)size completion:(void(^)(IKCPreparedKnobConfiguration* prepared))completion;
+
+@end
+
+/** Mutable knob configuration
+ *
+ * Starts with the same defaults as a new IOSKnobControl. Not thread-safe. Make an immutable copy before handing it to another thread.
+ */
+@interface IKCMutableKnobConfiguration : IKCKnobConfiguration
+
+@property (nonatomic) IKCMode mode;
+@property (nonatomic) IKCGesture gesture;
+@property (nonatomic) NSUInteger positions;
+@property (nonatomic, copy) NSArray* titles;
+@property (nonatomic) BOOL circular;
+@property (nonatomic) BOOL clockwise;
+@property (nonatomic) float min;
+@property (nonatomic) float max;
+@property (nonatomic, copy) NSString* fontName;
+@property (nonatomic) BOOL zoomTopTitle;
+@property (nonatomic) CGFloat zoomPointSize;
+@property (nonatomic) CGFloat knobRadius;
+@property (nonatomic) CGFloat fingerHoleRadius;
+@property (nonatomic) CGFloat fingerHoleMargin;
+@property (nonatomic) UIColor* shadowColor;
+@property (nonatomic) CGFloat shadowOpacity;
+@property (nonatomic) CGSize shadowOffset;
+@property (nonatomic) CGFloat shadowRadius;
+#ifdef IKC_TITLE_RING
+@property (nonatomic) BOOL rendersTitleRing;
+#endif // IKC_TITLE_RING
+
+/** Set the fill color for a state
+ *
+ * Accepts the same states as IOSKnobControl's setFillColor:forState:.
+ */
+- (void)setFillColor:(UIColor*)color forState:(UIControlState)state;
+
+/** Set the title color for a state
+ *
+ * Accepts the same states as IOSKnobControl's setTitleColor:forState:.
+ */
+- (void)setTitleColor:(UIColor*)color forState:(UIControlState)state;
+
+@end
+
+/** A knob configuration ready to apply
+ *
+ * Returned by prepareForSize:scale:. Holds the resolved configuration and everything derived from it. Immutable and may be passed between threads.
+ */
+@interface IKCPreparedKnobConfiguration : NSObject
+
+/** The configuration with defaults resolved and the constraints of its mode applied */
+@property (nonatomic, readonly) IKCKnobConfiguration* configuration;
+/** The size the configuration was prepared for. In IKCModeRotaryDial, made square and large enough for the finger holes. */
+@property (nonatomic, readonly) CGSize size;
+/** Time taken to prepare, in seconds */
+@property (nonatomic, readonly) NSTimeInterval preparationTime;
+
 @end
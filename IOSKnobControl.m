@@ -17,6 +17,14 @@
 #import <CoreText/CoreText.h>
 #import "IOSKnobControl.h"
 
+#ifdef IKC_TITLE_RING
+#import "IKCRing.h"
+#endif // IKC_TITLE_RING
+
+#ifdef IKC_SHADOW_BITMAP
+#import "IKCShadow.h"
+#endif // IKC_SHADOW_BITMAP
+
 /*
  * Return animations rotate through this many radians per second when self.timeScale == 1.0.
  */
@@ -37,6 +45,9 @@
 #define IKC_DEFAULT_FINGER_HOLE_RADIUS 22.0
 #define IKC_TITLE_MARGIN_RATIO 0.2
 
+// Maximum number of generated paths held by the shared path cache.
+#define IKC_PATH_CACHE_LIMIT 64
+
 // Must match IKC_VERSION and IKC_BUILD from IOSKnobControl.h.
 #define IKC_TARGET_VERSION 0x010400
 #define IKC_TARGET_BUILD 1
@@ -76,6 +87,35 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
     return frame;
 }
 
+// the limits setPosition:animated: applies: clamped to [min, max] unless circular, and normalized to (-M_PI,M_PI] if requested.
+static float constrainPosition(float position, BOOL circular, BOOL normalized, float min, float max) {
+    if (circular == NO) {
+        position = MAX(position, min);
+        position = MIN(position, max);
+    }
+    else if (normalized) {
+        while (position > M_PI) position -= 2.0*M_PI;
+        while (position <= -M_PI) position += 2.0*M_PI;
+        if (position == -M_PI) position = M_PI;
+    }
+    return position;
+}
+
+// follows a one-finger rotation to a new touch angle in [-M_PI,M_PI]. returns the change in angle since touchStart.
+static float unwrapTouch(float touch, float* touchStart, float* currentTouch) {
+    if (*currentTouch > M_PI_2 && *currentTouch < M_PI && touch < -M_PI_2 && touch > -M_PI) {
+        // sudden jump from 2nd to 3rd quadrant. preserve continuity of the gesture by adjusting touchStart.
+        *touchStart -= 2.0*M_PI;
+    }
+    else if (*currentTouch < -M_PI_2 && *currentTouch > -M_PI && touch > M_PI_2 && touch < M_PI) {
+        // sudden jump from 3rd to 2nd quadrant. preserve continuity of the gesture by adjusting touchStart.
+        *touchStart += 2.0*M_PI;
+    }
+
+    *currentTouch = touch;
+    return touch - *touchStart;
+}
+
 #pragma mark - String deprecation wrapper
 
 @protocol NSStringDeprecatedMethods
@@ -429,256 +469,1580 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
 
 @end
 
-#pragma mark - IOSKnobControl implementation
-
-@interface IOSKnobControl()
-/*
- * Returns the nearest allowed position
+#pragma mark - IKCPathCache interface
+/**
+ * Shared cache of the paths the control generates (knob circle, pip, rotary dial, dial stop). Every knob of the same size and
+ * configuration generates exactly the same geometry, so each path is built once, copied into an immutable CGPath and shared by
+ * the shape layer, the mask and the shadow of every knob that needs it. Paths are owned by the cache. Only access it from the
+ * main thread.
  */
-@property (readonly) float nearestPosition;
-@property (readonly) BOOL currentFillColorIsOpaque;
-@property (readonly) UIBezierPath* rotaryDialPath;
-@property (readonly) CGRect roundedBounds;
-@end
+@interface IKCPathCache : NSObject
 
-@implementation IOSKnobControl {
-    float touchStart, positionStart, currentTouch;
-    UIGestureRecognizer* gestureRecognizer;
-    CALayer* imageLayer, *backgroundLayer, *foregroundLayer, *middleLayer, *shadowLayer;
-    CAShapeLayer* shapeLayer, *pipLayer, *stopLayer;
-    NSMutableArray* markings, *dialMarkings;
-    UIImage* images[4];
-    UIColor* fillColor[4];
-    UIColor* titleColor[4];
-    BOOL rotating;
-    int lastNumberDialed, _numberDialed;
-    NSInteger lastPositionIndex;
-}
+@property (nonatomic, readonly) NSUInteger hits, misses;
 
-@dynamic positionIndex, nearestPosition;
++ (instancetype)sharedCache;
 
-#pragma mark - Object Lifecycle
+- (CGPathRef)pathForKey:(NSString*)key generator:(UIBezierPath*(^)(void))generator;
+- (void)setPath:(CGPathRef)path forKey:(NSString*)key;
+- (NSString*)keyForPath:(CGPathRef)path;
+- (void)removeAllPaths;
+- (void)resetStatistics;
 
-- (instancetype)initWithFrame:(CGRect)frame
+@end
+
+#pragma mark - IKCPathCache implementation
+@implementation IKCPathCache {
+    NSMutableDictionary* paths;
+    // keys, least recently used first
+    NSMutableOrderedSet* order;
+}
+
++ (instancetype)sharedCache
 {
-    self = [super initWithFrame:frame];
-    if (self) {
-        [self setDefaults];
-        [self setupGestureRecognizer];
-    }
-    return self;
+    static IKCPathCache* _sharedCache;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        _sharedCache = [[self alloc] init];
+    });
+    return _sharedCache;
 }
 
-- (instancetype)initWithFrame:(CGRect)frame image:(UIImage *)image
+- (instancetype)init
 {
-    self = [super initWithFrame:frame];
+    self = [super init];
     if (self) {
-        [self setImage:image forState:UIControlStateNormal];
-        [self setDefaults];
-        [self setupGestureRecognizer];
+        paths = [NSMutableDictionary dictionary];
+        order = [NSMutableOrderedSet orderedSet];
+        _hits = _misses = 0;
+
+        // the cache is cheap to rebuild, so just let it go under pressure.
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(removeAllPaths) name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
     }
     return self;
 }
 
-- (instancetype)initWithFrame:(CGRect)frame imageNamed:(NSString *)imageSetName
+- (void)dealloc
 {
-    self = [super initWithFrame:frame];
-    if (self) {
-        UIImage* image = [UIImage imageNamed:imageSetName];
-        [self setImage:image forState:UIControlStateNormal];
-        [self setDefaults];
-        [self setupGestureRecognizer];
-    }
-    return self;
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
 }
 
-- (void)setDefaults
+- (CGPathRef)pathForKey:(NSString *)key generator:(UIBezierPath *(^)(void))generator
 {
-    _mode = IKCModeLinearReturn;
-    _clockwise = NO;
-    _position = 0.0;
-    _circular = YES;
-    _min = -M_PI + IKC_EPSILON;
-    _max = M_PI - IKC_EPSILON;
-    _positions = 2;
-    _timeScale = 1.0;
-    _gesture = IKCGestureOneFingerRotation;
-    _normalized = YES;
-    _fontName = @"Helvetica";
-    _shadowRadius = 3.0;
-    _shadowColor = [UIColor blackColor];
-    _shadowOpacity = 0.0;
-    _shadowOffset = CGSizeMake(0.0, 3.0);
-    _knobRadius = 0.5 * self.bounds.size.width;
-    _zoomTopTitle = YES;
-    _zoomPointSize = 0.0;
-    _drawsAsynchronously = NO;
-    _fingerHoleRadius = IKC_DEFAULT_FINGER_HOLE_RADIUS;
-    _masksImage = NO;
-    _gestureSensitivity = 1.0;
+    id path = paths[key];
+    if (path) {
+        ++ _hits;
+        [order removeObject:key];
+        [order addObject:key];
+        return (__bridge CGPathRef)path;
+    }
 
-    // Default margin is the same as the space between adjacent holes
-    _fingerHoleMargin = (_knobRadius - 4.86*_fingerHoleRadius)/2.93;
+    ++ _misses;
 
-    rotating = NO;
-    lastNumberDialed = _numberDialed = -1;
+    path = CFBridgingRelease(CGPathCreateCopy(generator().CGPath));
+    [self insertPath:path forKey:key];
+    return (__bridge CGPathRef)path;
+}
 
-    lastPositionIndex = 0;
+/*
+ * For paths generated in advance, e.g. by IKCKnobConfiguration. The path must be immutable.
+ */
+- (void)setPath:(CGPathRef)path forKey:(NSString *)key
+{
+    if (paths[key]) return;
 
-    self.opaque = NO;
-    self.backgroundColor = [UIColor clearColor];
-    self.clipsToBounds = YES;
+    [self insertPath:(__bridge id)path forKey:key];
 }
 
-#pragma mark - Public Methods, Properties and Overrides
-
-- (UIImage *)imageForState:(UIControlState)state
+/*
+ * Adds a path that isn't in the cache yet, evicting the least recently used one if the cache is full.
+ */
+- (void)insertPath:(id)path forKey:(NSString*)key
 {
-    int index = [self indexForState:state];
-    /*
-     * Like UIButton, use the image for UIControlStateNormal if none present.
-     */
-    // Mmmm. Double square brackets in the last expression of the ternary conditional: outer for the array subscript, inner for a method call.
-    return index >= 0 && images[index] ? images[index] : images[[self indexForState:UIControlStateNormal]];
+    // DEBT: Arbitrary. Knobs are rarely resized, so this is mainly a guard against unbounded growth.
+    if (paths.count >= IKC_PATH_CACHE_LIMIT) {
+        [paths removeObjectForKey:order.firstObject];
+        [order removeObjectAtIndex:0];
+    }
+
+    paths[key] = path;
+    [order addObject:key];
 }
 
-- (void)setImage:(UIImage *)image forState:(UIControlState)state
+/*
+ * The key describes the path's content, so it identifies the path even after the entry is gone. Returns nil for a path not in the cache.
+ */
+- (NSString *)keyForPath:(CGPathRef)path
 {
-    int index = [self indexForState:state];
-    /*
-     * Don't accept mixed states here. Cannot pass, e.g., UIControlStateHighlighted & UIControlStateDisabled.
-     * Those values are ignored here.
-     */
-    if (state == UIControlStateNormal || state == UIControlStateHighlighted || state == UIControlStateDisabled || state == UIControlStateSelected) {
-        images[index] = image;
-    }
+    id object = (__bridge id)path;
+    return [paths keysOfEntriesPassingTest:^BOOL(id key, id obj, BOOL *stop) {
+        *stop = obj == object;
+        return *stop;
+    }].anyObject;
+}
 
-    /*
-     * The method parameter state must be one of the four enumerated values listed above.
-     * But self.state could be a mixed state. Conceivably, the control could be
-     * both disabled and highlighted. In that case, since disabled is numerically
-     * greater than highlighted, we return the index/image for UIControlStateDisabled.
-     * (See indexForState: below.) That is to say, the following expression is always true:
-     * [self indexForState:UIControlStateDisabled] == [self indexForState:UIControlStateHighlighted|UIControlStateDisabled]
-     * If we just now changed the image currently in use (the image for the current state), update it now.
-     */
-    if (index == [self indexForState:self.state]) {
-        [self setNeedsLayout];
-    }
+/*
+ * Also called on a memory warning, which shouldn't make the statistics meaningless, so they are reset separately.
+ */
+- (void)removeAllPaths
+{
+    [paths removeAllObjects];
+    [order removeAllObjects];
 }
 
-- (UIColor *)fillColorForState:(UIControlState)state
+- (void)resetStatistics
 {
-    int index = [self indexForState:state];
-    UIColor* color = index >= 0 && fillColor[index] ? fillColor[index] : fillColor[[self indexForState:UIControlStateNormal]];
+    _hits = _misses = 0;
+}
 
-    if (!color) {
-        CGFloat red, green, blue, alpha;
-        [self.getTintColor getRed:&red green:&green blue:&blue alpha:&alpha];
+@end
 
-        CGFloat hue, saturation, brightness;
-        [self.getTintColor getHue:&hue saturation:&saturation brightness:&brightness alpha:&alpha];
+#pragma mark - IKCWeakTarget interface
+/**
+ * Forwards a CADisplayLink callback to a target it doesn't retain, so a display link can't keep a knob control alive. If the target
+ * is gone, the display link is invalidated.
+ */
+@interface IKCWeakTarget : NSObject
 
-        if ((red == green && green == blue) || brightness < 0.02) {
-            /*
-             * This is for any shade of gray from black to white. Unfortunately, black is not really black.
-             * It comes out as a red hue. Hence the brightness test above.
-             */
-            CGFloat value = ((NSNumber*)@[@(0.6), @(0.8), @(0.9), @(0.8)][index]).floatValue;
-            color = [UIColor colorWithRed:value green:value blue:value alpha:alpha];
-        }
-        else {
-            saturation = ((NSNumber*)@[@(1.0), @(0.7), @(0.2), @(0.7)][index]).floatValue;
-            brightness = ((NSNumber*)@[@(0.9), @(1.0), @(0.9), @(1.0)][index]).floatValue;
-            color = [UIColor colorWithHue:hue saturation:saturation brightness:brightness alpha:alpha];
-        }
-    }
++ (instancetype)weakTargetWithTarget:(id)target selector:(SEL)selector;
 
-    return color;
+- (void)displayLinkFired:(CADisplayLink*)link;
+
+@end
+
+#pragma mark - IKCWeakTarget implementation
+@implementation IKCWeakTarget {
+    __weak id target;
+    SEL selector;
 }
 
-- (void)setFillColor:(UIColor *)color forState:(UIControlState)state
++ (instancetype)weakTargetWithTarget:(id)target selector:(SEL)selector
 {
-    int index = [self indexForState:state];
-    if (state == UIControlStateNormal || state == UIControlStateHighlighted || state == UIControlStateDisabled || state == UIControlStateSelected) {
-        fillColor[index] = color;
-    }
+    IKCWeakTarget* weakTarget = [[self alloc] init];
+    weakTarget->target = target;
+    weakTarget->selector = selector;
+    return weakTarget;
+}
 
-    if (index == [self indexForState:self.state]) {
-        [self setNeedsLayout];
+- (void)displayLinkFired:(CADisplayLink *)link
+{
+    id strongTarget = target;
+    if (!strongTarget) {
+        [link invalidate];
+        return;
     }
+
+    // performSelector: would leave ARC guessing about the return value
+    void (*fired)(id, SEL, CADisplayLink*) = (void (*)(id, SEL, CADisplayLink*))[strongTarget methodForSelector:selector];
+    fired(strongTarget, selector, link);
 }
 
-- (UIColor *)titleColorForState:(UIControlState)state
-{
-    int index = [self indexForState:state];
-    UIColor* color = index >= 0 && titleColor[index] ? titleColor[index] : titleColor[[self indexForState:UIControlStateNormal]];
+@end
 
-    if (!color) {
-        CGFloat red, green, blue, alpha;
-        [self.getTintColor getRed:&red green:&green blue:&blue alpha:&alpha];
+#pragma mark - IKCImageLoader interface
+/**
+ * Loads image sets from the asset catalog and decodes them on a background queue, so that the first render doesn't decode on the
+ * main thread. Decoded images are kept in a cache that the system may purge. Concurrent requests for the same image share one decode.
+ * Only call from the main thread. Completion blocks are called on the main thread, synchronously if the image is already decoded.
+ */
+@interface IKCImageLoader : NSObject
 
-        CGFloat hue, saturation, brightness;
-        [self.getTintColor getHue:&hue saturation:&saturation brightness:&brightness alpha:&alpha];
++ (instancetype)sharedLoader;
 
-        if ((red == green && green == blue) || brightness < 0.02) {
-            /*
-             * This is for any shade of gray from black to white. Unfortunately, black is not really black.
-             * It comes out as a red hue. Hence the brightness test above.
-             */
-            CGFloat value = ((NSNumber*)@[@(0.25), @(0.25), @(0.4), @(0.25)][index]).floatValue;
-            color = [UIColor colorWithRed:value green:value blue:value alpha:alpha];
-        }
-        else {
-            saturation = ((NSNumber*)@[@(1.0), @(1.0), @(0.2), @(1.0)][index]).floatValue;
-            brightness = 0.5; // ((NSNumber*)@[@(0.5), @(0.5), @(0.5), @(0.5)][index]).floatValue;
-            color = [UIColor colorWithHue:hue saturation:saturation brightness:brightness alpha:alpha];
-        }
-    }
+- (void)loadImageNamed:(NSString*)name priority:(dispatch_queue_priority_t)priority completion:(void(^)(UIImage* image))completion;
 
-    return color;
+- (void)removeAllImages;
+
+@end
+
+#pragma mark - IKCImageLoader implementation
+@implementation IKCImageLoader {
+    NSCache* decodedImages;
+    NSMutableDictionary* waiting;
 }
 
-- (void)setTitleColor:(UIColor *)color forState:(UIControlState)state
++ (instancetype)sharedLoader
 {
-    int index = [self indexForState:state];
-    if (state == UIControlStateNormal || state == UIControlStateHighlighted || state == UIControlStateDisabled || state == UIControlStateSelected) {
-        titleColor[index] = color;
-    }
-
-    if (index == [self indexForState:self.state]) {
-        [self setNeedsLayout];
-    }
+    static IKCImageLoader* _sharedLoader;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        _sharedLoader = [[self alloc] init];
+    });
+    return _sharedLoader;
 }
 
-- (void)setFrame:(CGRect)frame
+- (instancetype)init
 {
-    if (_mode == IKCModeRotaryDial)
-    {
-        frame = adjustFrame(frame, _fingerHoleRadius);
+    self = [super init];
+    if (self) {
+        decodedImages = [[NSCache alloc] init];
+        waiting = [NSMutableDictionary dictionary];
     }
-    [super setFrame:frame];
-    [self setNeedsLayout];
+    return self;
 }
 
-- (void)setBackgroundImage:(UIImage *)backgroundImage
+- (void)loadImageNamed:(NSString *)name priority:(dispatch_queue_priority_t)priority completion:(void (^)(UIImage *))completion
 {
-    _backgroundImage = backgroundImage;
-    [self setNeedsLayout];
+    // NSNull means we already looked, and there's no such image.
+    id cached = [decodedImages objectForKey:name];
+    if (cached) {
+        completion(cached == [NSNull null] ? nil : cached);
+        return;
+    }
+
+    NSMutableArray* completions = waiting[name];
+    if (completions) {
+        [completions addObject:[completion copy]];
+        return;
+    }
+    waiting[name] = [NSMutableArray arrayWithObject:[completion copy]];
+
+    /*
+     * imageNamed: isn't thread-safe before iOS 9, so look the image up here. That's cheap. It's the decode, when the image is first
+     * drawn, that's expensive, and that happens on the background queue.
+     */
+    UIImage* image = [UIImage imageNamed:name];
+    if (!image) {
+        [self finishLoadingImageNamed:name image:nil];
+        return;
+    }
+
+    dispatch_async(dispatch_get_global_queue(priority, 0), ^{
+        // UIKit drawing is thread-safe as of iOS 4.
+        UIGraphicsBeginImageContextWithOptions(image.size, NO, image.scale);
+        [image drawAtPoint:CGPointZero];
+        UIImage* decoded = UIGraphicsGetImageFromCurrentImageContext();
+        UIGraphicsEndImageContext();
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self finishLoadingImageNamed:name image:decoded ? decoded : image];
+        });
+    });
 }
 
-- (void)setForegroundImage:(UIImage *)foregroundImage
+- (void)removeAllImages
 {
-    _foregroundImage = foregroundImage;
-    [self setNeedsLayout];
+    // decodes in flight still complete for whoever is waiting on them
+    [decodedImages removeAllObjects];
 }
 
-- (void)setEnabled:(BOOL)enabled
+- (void)finishLoadingImageNamed:(NSString*)name image:(UIImage*)image
 {
-    [super setEnabled:enabled];
-    gestureRecognizer.enabled = enabled;
+    [decodedImages setObject:image ? image : [NSNull null] forKey:name];
 
-    [self updateControlState];
+    NSArray* completions = waiting[name];
+    [waiting removeObjectForKey:name];
+
+    for (void(^completion)(UIImage*) in completions) {
+        completion(image);
+    }
+}
+
+@end
+
+#pragma mark - Geometry and font fitting
+
+/*
+ * Everything the control derives from its configuration: generated paths, fitted font sizes and the title ring. These depend only
+ * on their arguments, so IKCKnobConfiguration can run them on a background queue. The instance methods that use them
+ * (knobPath, fontSizeForTitles, etc.) just pass in the control's properties.
+ */
+
+static NSString* knobPathKey(CGSize size, CGFloat knobRadius)
+{
+    return [NSString stringWithFormat:@"knob:%f:%f:%f", size.width, size.height, knobRadius];
+}
+
+static UIBezierPath* knobBezierPath(CGSize size, CGFloat knobRadius)
+{
+    return [UIBezierPath bezierPathWithArcCenter:CGPointMake(size.width*0.5, size.height*0.5) radius:knobRadius startAngle:0.0 endAngle:2.0*M_PI clockwise:NO];
+}
+
+static NSString* pipPathKey(CGSize size)
+{
+    return [NSString stringWithFormat:@"pip:%f:%f", size.width, size.height];
+}
+
+static UIBezierPath* pipBezierPath(CGSize size)
+{
+    return [UIBezierPath bezierPathWithArcCenter:CGPointMake(size.width*0.5, size.height*0.08) radius:size.width*0.03 startAngle:0.0 endAngle:2.0*M_PI clockwise:NO];
+}
+
+static NSString* rotaryDialPathKey(CGSize size, CGFloat knobRadius, CGFloat fingerHoleRadius, CGFloat fingerHoleMargin)
+{
+    return [NSString stringWithFormat:@"dial:%f:%f:%f:%f:%f", size.width, size.height, knobRadius, fingerHoleRadius, fingerHoleMargin];
+}
+
+static UIBezierPath* rotaryDialBezierPath(CGSize size, CGFloat knobRadius, CGFloat fingerHoleRadius, CGFloat fingerHoleMargin)
+{
+    UIBezierPath* path = [UIBezierPath bezierPathWithArcCenter:CGPointMake(size.width*0.5, size.height*0.5) radius:knobRadius startAngle:0.0 endAngle:2.0*M_PI clockwise:NO];
+
+    float const centerRadius = knobRadius - fingerHoleMargin - fingerHoleRadius;
+
+    int j;
+    for (j=0; j<10; ++j)
+    {
+        double centerAngle = M_PI_4 + j*M_PI/6.0;
+        double centerX = size.width*0.5 + centerRadius * cos(centerAngle);
+        double centerY = size.height*0.5 - centerRadius * sin(centerAngle);
+        [path addArcWithCenter:CGPointMake(centerX, centerY) radius:fingerHoleRadius startAngle:M_PI_2-centerAngle endAngle:1.5*M_PI-centerAngle clockwise:YES];
+    }
+    for (--j; j>=0; --j)
+    {
+        double centerAngle = M_PI_4 + j*M_PI/6.0;
+        double centerX = size.width*0.5 + centerRadius * cos(centerAngle);
+        double centerY = size.height*0.5 - centerRadius * sin(centerAngle);
+        [path addArcWithCenter:CGPointMake(centerX, centerY) radius:fingerHoleRadius startAngle:1.5*M_PI-centerAngle endAngle:M_PI_2-centerAngle clockwise:YES];
+    }
+
+    return path;
+}
+
+static NSString* dialStopPathKey(CGSize size)
+{
+    return [NSString stringWithFormat:@"stop:%f:%f", size.width, size.height];
+}
+
+static UIBezierPath* dialStopBezierPath(CGSize size)
+{
+    float const stopWidth = 0.05;
+
+    // the stop is an isosceles triangle at 4:00 (-M_PI/6) pointing inward radially.
+
+    // the near point is the point nearest the center of the dial, at the edge of the
+    // outer tap ring. (see handleTap: for where the 0.586 comes from.)
+
+    float nearX = size.width*0.5 * (1.0 + 0.586 * sqrt(3.0) * 0.5);
+    float nearY = size.height*0.5 * (1.0 + 0.586 * 0.5);
+
+    // the opposite edge is tangent to the perimeter of the dial. the width of the far side
+    // is stopWidth * self.frame.size.height * 0.5.
+
+    float upperEdgeX = size.width*0.5 * (1.0 + sqrt(3.0) * 0.5 + stopWidth * 0.5);
+    float upperEdgeY = size.height*0.5 * (1.0 + 0.5 - stopWidth * sqrt(3.0)*0.5);
+
+    float lowerEdgeX = size.width*0.5 * (1.0 + sqrt(3.0) * 0.5 - stopWidth * 0.5);
+    float lowerEdgeY = size.height*0.5 * (1.0 + 0.5 + stopWidth * sqrt(3.0)*0.5);
+
+    UIBezierPath* path = [UIBezierPath bezierPath];
+    [path moveToPoint:CGPointMake(nearX, nearY)];
+    [path addLineToPoint:CGPointMake(lowerEdgeX, lowerEdgeY)];
+    [path addLineToPoint:CGPointMake(upperEdgeX, upperEdgeY)];
+    [path closePath];
+
+    return path;
+}
+
+/*
+ * See indexForState:.
+ */
+static int indexForControlState(UIControlState state)
+{
+    if ((state & UIControlStateApplication) != 0) return -1;
+    if ((state & UIControlStateSelected) != 0) return 3;
+    if ((state & UIControlStateDisabled) != 0) return 2;
+    if ((state & UIControlStateHighlighted) != 0) return 1;
+    return 0;
+}
+
+static BOOL fontNameIsAvailable(NSString* fontName)
+{
+    UIFontDescriptor* fontDescriptor = [UIFontDescriptor fontDescriptorWithName:fontName size:0.0];
+    if ([fontDescriptor matchingFontDescriptorsWithMandatoryKeys:nil].count > 0) return YES;
+
+    /*
+     * On iOS 6, the matchingBlah: call returns 0 for valid fonts. So we do this check too
+     * before giving up.
+     */
+    fontDescriptor = [UIFontDescriptor fontDescriptorWithName:fontName size:17.0];
+    return [UIFont fontWithDescriptor:fontDescriptor size:0.0] || [UIFont fontWithName:fontName size:17.0];
+}
+
+static UIFont* fontWithNameAndSize(NSString* fontName, CGFloat fontSize)
+{
+    /*
+     * Different things work in different environments, so:
+     */
+
+    UIFontDescriptor* fontDescriptor = [UIFontDescriptor fontDescriptorWithName:fontName size:fontSize];
+    UIFont* font = [UIFont fontWithDescriptor:fontDescriptor size:0.0];
+    if (font) return font;
+
+    return [UIFont fontWithName:fontName size:fontSize];
+}
+
+/*
+ * Point size of the Dynamic Type headline style on iOS 7+, 17 below.
+ */
+static CGFloat headlineStyleSize(void)
+{
+    if ([UIFontDescriptor respondsToSelector:@selector(preferredFontDescriptorWithTextStyle:)]) {
+        return [UIFontDescriptor preferredFontDescriptorWithTextStyle:UIFontTextStyleHeadline].pointSize;
+    }
+    return 17.0;
+}
+
+/*
+ * The point size to which to zoom the top title, from zoomPointSize or Dynamic Type. May be no larger than fontSize, in which case there's no zoom.
+ */
+static CGFloat headlinePointSize(CGFloat zoomPointSize, CGFloat fontSize)
+{
+    if (zoomPointSize != 0.0) return zoomPointSize;
+
+    if ([UIFontDescriptor respondsToSelector:@selector(preferredFontDescriptorWithTextStyle:)]) {
+        // iOS 7+
+        return MAX(headlineStyleSize(), fontSize);
+    }
+
+    // iOS 5 & 6
+    return 17.0;
+}
+
+static CGFloat titleCircumference(NSArray* titles, NSUInteger positions, UIFont* font)
+{
+    CGFloat max = 0.0;
+    for (id titleObject in titles) {
+
+        CGSize textSize = CGSizeZero;
+        if ([titleObject isKindOfClass:NSAttributedString.class]) {
+            NSAttributedString* attributed = (NSAttributedString*)titleObject;
+            textSize = attributed.size;
+        }
+        else if ([titleObject isKindOfClass:NSString.class]) {
+            textSize = [(NSString*)titleObject sizeOfTextWithFont:font];
+            // NSLog(@"textSize: %f x %f", textSize.width, textSize.height);
+        }
+        CGFloat width = textSize.width * (1.0 + 2.0 * IKC_TITLE_MARGIN_RATIO);
+        max = MAX(max, width);
+    }
+
+    return max * positions;
+}
+
+/*
+ * The largest font size (no larger than the headline style) at which the titles fit around a knob of the given width,
+ * spanning the given angle.
+ */
+static CGFloat fitFontSizeForTitles(NSArray* titles, NSUInteger positions, NSString* fontName, double angle, CGFloat width, CGFloat styleHeadlineSize)
+{
+    CGFloat fontSize;
+    for (fontSize = 23.0; fontSize >= 7.0; fontSize -= 1.0) {
+        if (fontSize > styleHeadlineSize) {
+            // don't display anything larger than the current headline size (max. 23 pts.)
+            continue;
+        }
+
+        // NSLog(@"Looking for font %@ %f", fontName, fontSize);
+        UIFont* font = fontWithNameAndSize(fontName, fontSize);
+        if (!font) {
+            // Assume it will eventually find one.
+            continue;
+        }
+
+        CGFloat circumference = titleCircumference(titles, positions, font);
+
+        // NSLog(@"With font size %f: circumference %f/%f", fontSize, circumference, angle*width*0.25);
+
+        // Empirically, this factor works out well. This allows for a little padding between text segments.
+        if (circumference <= angle*width*0.4) break;
+    }
+
+    return fontSize;
+}
+
+static NSString* fontSizeKey(NSUInteger positions, NSString* fontName, double angle, CGFloat width, CGFloat styleHeadlineSize)
+{
+    return [NSString stringWithFormat:@"%lu|%@|%f|%f|%f", (unsigned long)positions, fontName, angle, width, styleHeadlineSize];
+}
+
+#ifdef IKC_TITLE_RING
+/*
+ * One title per position. Positions without a title show the index.
+ */
+static NSArray* titleRingStrings(NSArray* titles, NSUInteger positions)
+{
+    NSMutableArray* strings = [NSMutableArray array];
+    int j;
+    for (j=0; j<positions; ++j) {
+        [strings addObject:j < titles.count ? titles[j] : [NSString stringWithFormat:@"%d", j]];
+    }
+    return strings;
+}
+
+/*
+ * Identifies a rendered ring. size is the rounded bounds size in points.
+ */
+static NSString* titleRingKey(NSArray* strings, NSString* fontName, CGFloat fontSize, CGFloat scale, CGSize size, CGFloat knobRadius,
+                              BOOL circular, BOOL clockwise, float min, float max)
+{
+    return [NSString stringWithFormat:@"%@|%@|%f|%f|%f|%f|%d|%d|%f|%f", [strings componentsJoinedByString:@"\x1f"], fontName, fontSize, scale,
+            size.width, knobRadius, circular, clockwise, min, max];
+}
+
+/*
+ * The zoomed top title is drawn over its small version in the ring, on the fill color, so a zooming knob can only use the ring
+ * if the fill color hides the small one in every state it can show.
+ */
+static BOOL titleRingIsUsable(NSArray* titles, BOOL zooming, UIColor* const fillColors[4])
+{
+    for (id titleObject in titles) {
+        // the ring can't honor per-title fonts and colors
+        if ([titleObject isKindOfClass:NSAttributedString.class]) return NO;
+    }
+    if (!zooming) return YES;
+
+    int j;
+    for (j=0; j<4; ++j) {
+        CGFloat red, green, blue, alpha = 1.0;
+        [fillColors[j] getRed:&red green:&green blue:&blue alpha:&alpha];
+        if (alpha < 1.0) return NO;
+    }
+    return YES;
+}
+
+static IKCRingGeometry titleRingGeometry(CGSize size, CGFloat scale, CGFloat knobRadius, NSUInteger positions, BOOL circular, BOOL clockwise, float min, float max)
+{
+    IKCRingGeometry geometry;
+    geometry.width = round(size.width * scale);
+    geometry.height = round(size.height * scale);
+    geometry.radius = knobRadius * scale;
+    geometry.positions = (unsigned)positions;
+    geometry.circular = circular;
+    geometry.clockwise = clockwise;
+    geometry.min = min;
+    geometry.max = max;
+    return geometry;
+}
+
+#pragma mark - Title ring rasterization
+
+/*
+ * Rasterizes each string with CoreText into a coverage bitmap and composites them all into one ring image with IKCRing. All sizes
+ * in pixels. Thread-safe: CoreText and bitmap contexts may be used off the main thread.
+ * Returns an alpha-only image, which the caller must release.
+ */
+static CGImageRef createTitleRingImage(NSArray* strings, NSString* fontName, CGFloat fontSize, IKCRingGeometry geometry)
+{
+    size_t const count = strings.count;
+    IKCGlyphBitmap* titles = calloc(count, sizeof(IKCGlyphBitmap));
+    IKCRingPlacement* placements = calloc(count, sizeof(IKCRingPlacement));
+    CGContextRef* contexts = calloc(count, sizeof(CGContextRef));
+
+    CTFontRef font = CTFontCreateWithName((__bridge CFStringRef)fontName, fontSize, NULL);
+    CFStringRef keys[] = { kCTFontAttributeName };
+    CFTypeRef values[] = { font };
+    CFDictionaryRef attributes = CFDictionaryCreate(kCFAllocatorDefault, (const void**)&keys, (const void**)&values, 1, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+    CFRelease(font);
+
+    size_t j;
+    for (j=0; j<count; ++j) {
+        CFAttributedStringRef attributed = CFAttributedStringCreate(kCFAllocatorDefault, (__bridge CFStringRef)strings[j], attributes);
+        CTLineRef line = CTLineCreateWithAttributedString(attributed);
+        CFRelease(attributed);
+
+        // same margins and baseline as IKCTextLayer
+        CGFloat ascent, descent, leading;
+        CGFloat width = CTLineGetTypographicBounds(line, &ascent, &descent, &leading);
+        CGFloat horizMargin = IKC_TITLE_MARGIN_RATIO * width;
+        CGFloat vertMargin = IKC_TITLE_MARGIN_RATIO * (ascent + descent + leading);
+
+        size_t bitmapWidth = ceil(width + 2.0 * horizMargin);
+        size_t bitmapHeight = ceil(ascent + descent + leading + 2.0 * vertMargin);
+
+        CGContextRef context = CGBitmapContextCreate(NULL, bitmapWidth, bitmapHeight, 8, 0, NULL, (CGBitmapInfo)kCGImageAlphaOnly);
+        if (context) {
+            CGContextClearRect(context, CGRectMake(0, 0, bitmapWidth, bitmapHeight));
+            CGContextSetTextPosition(context, horizMargin, leading + descent + vertMargin);
+            CTLineDraw(line, context);
+
+            contexts[j] = context;
+            titles[j].alpha = CGBitmapContextGetData(context);
+            titles[j].width = (int)bitmapWidth;
+            titles[j].height = (int)bitmapHeight;
+            titles[j].stride = CGBitmapContextGetBytesPerRow(context);
+        }
+        CFRelease(line);
+    }
+    CFRelease(attributes);
+
+    CGImageRef image = NULL;
+    CGContextRef ring = CGBitmapContextCreate(NULL, geometry.width, geometry.height, 8, 0, NULL, (CGBitmapInfo)kCGImageAlphaOnly);
+    if (ring) {
+        CGContextClearRect(ring, CGRectMake(0, 0, geometry.width, geometry.height));
+
+        IKCRingLayout(&geometry, titles, count, placements);
+        IKCRingComposite(CGBitmapContextGetData(ring), CGBitmapContextGetBytesPerRow(ring), &geometry, titles, placements, count);
+
+        image = CGBitmapContextCreateImage(ring);
+        CGContextRelease(ring);
+    }
+
+    for (j=0; j<count; ++j) {
+        if (contexts[j]) CGContextRelease(contexts[j]);
+    }
+    free(contexts);
+    free(placements);
+    free(titles);
+
+    return image;
+}
+#endif // IKC_TITLE_RING
+
+#ifdef IKC_SHADOW_BITMAP
+#pragma mark - Shadow bitmaps
+
+/*
+ * Shadow images, shared by every knob with the same outline and shadow settings, like the paths in IKCPathCache. Each entry is
+ * @[image, padding, source image or NSNull].
+ */
+static NSCache* shadowImageCache(void)
+{
+    static NSCache* cache;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        cache = [[NSCache alloc] init];
+    });
+    return cache;
+}
+
+static void hashPathElement(void* info, const CGPathElement* element)
+{
+    uint64_t* hash = info;
+    int count = 0;
+    switch (element->type) {
+        case kCGPathElementMoveToPoint:
+        case kCGPathElementAddLineToPoint:
+            count = 1;
+            break;
+        case kCGPathElementAddQuadCurveToPoint:
+            count = 2;
+            break;
+        case kCGPathElementAddCurveToPoint:
+            count = 3;
+            break;
+        case kCGPathElementCloseSubpath:
+            break;
+    }
+
+    // FNV-1a over the element type and the bytes of its points
+    const unsigned char* bytes = (const unsigned char*)&element->type;
+    for (size_t j=0; j<sizeof(element->type); ++j) *hash = (*hash ^ bytes[j]) * 1099511628211ull;
+    bytes = (const unsigned char*)element->points;
+    for (size_t j=0; j<count * sizeof(CGPoint); ++j) *hash = (*hash ^ bytes[j]) * 1099511628211ull;
+}
+
+/*
+ * Identifies a path by its elements, for client paths, which have no IKCPathCache key.
+ */
+static NSString* pathContentKey(CGPathRef path)
+{
+    uint64_t hash = 14695981039346656037ull;
+    CGPathApply(path, &hash, hashPathElement);
+    return [NSString stringWithFormat:@"path:%016llx:%@", hash, NSStringFromCGRect(CGPathGetBoundingBox(path))];
+}
+
+/*
+ * Fills the outline (path, or if NULL, the alpha channel of image drawn into the bounds) of a layer of the given size in points, blurs
+ * it with IKCShadowBlur and colors it. The image covers the bounds plus *padding points on every side. Safe on any thread.
+ * Returns NULL on failure. Otherwise the caller must release the image.
+ */
+static CGImageRef createShadowImage(CGPathRef path, CGImageRef image, CGSize size, CGFloat scale, CGFloat radius, const CGFloat* rgba, CGFloat opacity, CGFloat* padding)
+{
+    // DEBT: Core Animation doesn't document its blur. Treating shadowRadius as the standard deviation is close enough to be indistinguishable.
+    float sigma = radius * scale;
+    int margin = IKCShadowPadding(sigma);
+    size_t width = ceil(size.width * scale) + 2 * margin;
+    size_t height = ceil(size.height * scale) + 2 * margin;
+
+    CGContextRef maskContext = CGBitmapContextCreate(NULL, width, height, 8, 0, NULL, (CGBitmapInfo)kCGImageAlphaOnly);
+    if (!maskContext) return NULL;
+    CGContextClearRect(maskContext, CGRectMake(0, 0, width, height));
+
+    if (path) {
+        // paths are in layer coordinates, with y down
+        CGContextTranslateCTM(maskContext, margin, height - margin);
+        CGContextScaleCTM(maskContext, scale, -scale);
+        CGContextAddPath(maskContext, path);
+        CGContextFillPath(maskContext);
+    }
+    else {
+        CGContextDrawImage(maskContext, CGRectMake(margin, margin, width - 2 * margin, height - 2 * margin), image);
+    }
+
+    const uint8_t* coverage = CGBitmapContextGetData(maskContext);
+    size_t const maskStride = CGBitmapContextGetBytesPerRow(maskContext);
+    if (IKCShadowBlur(CGBitmapContextGetData(maskContext), (int)width, (int)height, maskStride, sigma, NULL)) {
+        // out of scratch memory. an unblurred mask is no shadow.
+        CGContextRelease(maskContext);
+        return NULL;
+    }
+
+    CGImageRef shadow = NULL;
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(NULL, width, height, 8, 0, colorSpace, (CGBitmapInfo)kCGImageAlphaPremultipliedLast);
+    CGColorSpaceRelease(colorSpace);
+
+    if (context) {
+        // premultiplied RGBA. one multiply per pixel, so just do it here.
+        uint8_t* pixels = CGBitmapContextGetData(context);
+        size_t const stride = CGBitmapContextGetBytesPerRow(context);
+        float const alpha = rgba[3] * opacity;
+        float const r = rgba[0] * alpha * 255.0f, g = rgba[1] * alpha * 255.0f, b = rgba[2] * alpha * 255.0f, a = alpha * 255.0f;
+
+        size_t x, y;
+        for (y=0; y<height; ++y) {
+            const uint8_t* in = coverage + y * maskStride;
+            uint8_t* out = pixels + y * stride;
+            for (x=0; x<width; ++x) {
+                float c = in[x] * (1.0f / 255.0f);
+                out[4*x] = (uint8_t)(r * c + 0.5f);
+                out[4*x+1] = (uint8_t)(g * c + 0.5f);
+                out[4*x+2] = (uint8_t)(b * c + 0.5f);
+                out[4*x+3] = (uint8_t)(a * c + 0.5f);
+            }
+        }
+
+        shadow = CGBitmapContextCreateImage(context);
+        CGContextRelease(context);
+    }
+    CGContextRelease(maskContext);
+
+    *padding = margin / scale;
+    return shadow;
+}
+#endif // IKC_SHADOW_BITMAP
+
+#pragma mark - IKCKnobConfiguration implementation
+
+/*
+ * The readonly properties are readwrite here, so IKCMutableKnobConfiguration only has to redeclare them.
+ */
+@interface IKCKnobConfiguration()
+@property (nonatomic) IKCMode mode;
+@property (nonatomic) IKCGesture gesture;
+@property (nonatomic) NSUInteger positions;
+@property (nonatomic, copy) NSArray* titles;
+@property (nonatomic) BOOL circular;
+@property (nonatomic) BOOL clockwise;
+@property (nonatomic) float min;
+@property (nonatomic) float max;
+@property (nonatomic, copy) NSString* fontName;
+@property (nonatomic) BOOL zoomTopTitle;
+@property (nonatomic) CGFloat zoomPointSize;
+@property (nonatomic) CGFloat knobRadius;
+@property (nonatomic) CGFloat fingerHoleRadius;
+@property (nonatomic) CGFloat fingerHoleMargin;
+@property (nonatomic) UIColor* shadowColor;
+@property (nonatomic) CGFloat shadowOpacity;
+@property (nonatomic) CGSize shadowOffset;
+@property (nonatomic) CGFloat shadowRadius;
+#ifdef IKC_TITLE_RING
+@property (nonatomic) BOOL rendersTitleRing;
+#endif // IKC_TITLE_RING
+
+- (void)storeFillColor:(UIColor*)color forState:(UIControlState)state;
+- (void)storeTitleColor:(UIColor*)color forState:(UIControlState)state;
+/*
+ * Only the colors actually set, with no fallback. index as returned by indexForState:.
+ */
+- (UIColor*)fillColorAtIndex:(int)index;
+- (UIColor*)titleColorAtIndex:(int)index;
+@end
+
+@interface IKCPreparedKnobConfiguration()
+@property (nonatomic) IKCKnobConfiguration* configuration;
+@property (nonatomic) CGSize size;
+@property (nonatomic) NSTimeInterval preparationTime;
+/*
+ * Whether knobRadius and fingerHoleMargin were defaults resolved against size, to be resolved again for a control of another size
+ */
+@property (nonatomic) BOOL knobRadiusFromSize, fingerHoleMarginFromSize;
+/*
+ * Cache key -> immutable CGPath, for IKCPathCache
+ */
+@property (nonatomic) NSDictionary* paths;
+/*
+ * The result of fontSizeForTitles, if fontSizeKey matches
+ */
+@property (nonatomic, copy) NSString* fontSizeKey;
+@property (nonatomic) CGFloat fontSize;
+#ifdef IKC_TITLE_RING
+@property (nonatomic, copy) NSString* ringKey;
+@property (nonatomic) id ringImage;
+#endif // IKC_TITLE_RING
+@end
+
+@implementation IKCKnobConfiguration {
+    UIColor* fillColor[4];
+    UIColor* titleColor[4];
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        // same as IOSKnobControl's setDefaults
+        _mode = IKCModeLinearReturn;
+        _gesture = IKCGestureOneFingerRotation;
+        _positions = 2;
+        _circular = YES;
+        _clockwise = NO;
+        _min = -M_PI + IKC_EPSILON;
+        _max = M_PI - IKC_EPSILON;
+        _fontName = @"Helvetica";
+        _zoomTopTitle = YES;
+        _zoomPointSize = 0.0;
+        _knobRadius = -1.0;
+        _fingerHoleRadius = IKC_DEFAULT_FINGER_HOLE_RADIUS;
+        _fingerHoleMargin = -1.0;
+        _shadowColor = [UIColor blackColor];
+        _shadowOpacity = 0.0;
+        _shadowOffset = CGSizeMake(0.0, 3.0);
+        _shadowRadius = 3.0;
+    }
+    return self;
+}
+
+- (void)copyConfigurationTo:(IKCKnobConfiguration*)other
+{
+    other.mode = _mode;
+    other.gesture = _gesture;
+    other.positions = _positions;
+    other.titles = _titles;
+    other.circular = _circular;
+    other.clockwise = _clockwise;
+    other.min = _min;
+    other.max = _max;
+    other.fontName = _fontName;
+    other.zoomTopTitle = _zoomTopTitle;
+    other.zoomPointSize = _zoomPointSize;
+    other.knobRadius = _knobRadius;
+    other.fingerHoleRadius = _fingerHoleRadius;
+    other.fingerHoleMargin = _fingerHoleMargin;
+    other.shadowColor = _shadowColor;
+    other.shadowOpacity = _shadowOpacity;
+    other.shadowOffset = _shadowOffset;
+    other.shadowRadius = _shadowRadius;
+#ifdef IKC_TITLE_RING
+    other.rendersTitleRing = _rendersTitleRing;
+#endif // IKC_TITLE_RING
+
+    int j;
+    for (j=0; j<4; ++j) {
+        other->fillColor[j] = fillColor[j];
+        other->titleColor[j] = titleColor[j];
+    }
+}
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    // immutable
+    if ([self isMemberOfClass:IKCKnobConfiguration.class]) return self;
+
+    IKCKnobConfiguration* copy = [[IKCKnobConfiguration allocWithZone:zone] init];
+    [self copyConfigurationTo:copy];
+    return copy;
+}
+
+- (id)mutableCopyWithZone:(NSZone *)zone
+{
+    IKCMutableKnobConfiguration* copy = [[IKCMutableKnobConfiguration allocWithZone:zone] init];
+    [self copyConfigurationTo:copy];
+    return copy;
+}
+
+- (UIColor *)fillColorForState:(UIControlState)state
+{
+    int index = indexForControlState(state);
+    return index >= 0 && fillColor[index] ? fillColor[index] : fillColor[0];
+}
+
+- (UIColor *)fillColorAtIndex:(int)index
+{
+    return fillColor[index];
+}
+
+- (UIColor *)titleColorAtIndex:(int)index
+{
+    return titleColor[index];
+}
+
+- (void)storeFillColor:(UIColor *)color forState:(UIControlState)state
+{
+    if (state == UIControlStateNormal || state == UIControlStateHighlighted || state == UIControlStateDisabled || state == UIControlStateSelected) {
+        fillColor[indexForControlState(state)] = color;
+    }
+}
+
+- (void)storeTitleColor:(UIColor *)color forState:(UIControlState)state
+{
+    if (state == UIControlStateNormal || state == UIControlStateHighlighted || state == UIControlStateDisabled || state == UIControlStateSelected) {
+        titleColor[indexForControlState(state)] = color;
+    }
+}
+
+- (UIColor *)titleColorForState:(UIControlState)state
+{
+    int index = indexForControlState(state);
+    return index >= 0 && titleColor[index] ? titleColor[index] : titleColor[0];
+}
+
+- (IKCPreparedKnobConfiguration *)prepareForSize:(CGSize)size scale:(CGFloat)scale
+{
+    CFTimeInterval start = CACurrentMediaTime();
+
+    /*
+     * Resolve defaults and apply the same constraints the control's setters do.
+     */
+    IKCMutableKnobConfiguration* c = [self mutableCopy];
+    if (c.mode == IKCModeRotaryDial) {
+        size = adjustFrame(CGRectMake(0, 0, size.width, size.height), c.fingerHoleRadius).size;
+
+        if (c.gesture == IKCGestureVerticalPan || c.gesture == IKCGestureTwoFingerRotation) {
+            c.gesture = IKCGestureOneFingerRotation;
+        }
+        c.clockwise = NO;
+        c.circular = NO;
+        c.max = IKC_EPSILON;
+        c.min = -11.0*M_PI/6.0;
+    }
+    else {
+        if (c.max - c.min >= 2.0*M_PI) c.max = c.min + 2.0*M_PI;
+        if (c.max < c.min) c.max = c.min;
+    }
+
+    BOOL knobRadiusFromSize = c.knobRadius < 0.0;
+    BOOL fingerHoleMarginFromSize = c.fingerHoleMargin < 0.0;
+    if (knobRadiusFromSize) c.knobRadius = 0.5 * size.width;
+    if (fingerHoleMarginFromSize) c.fingerHoleMargin = (c.knobRadius - 4.86*c.fingerHoleRadius)/2.93;
+
+    if (c.fontName && !fontNameIsAvailable(c.fontName)) {
+        NSLog(@"Failed to find font name \"%@\".", c.fontName);
+        c.fontName = nil;
+    }
+
+    IKCPreparedKnobConfiguration* prepared = [[IKCPreparedKnobConfiguration alloc] init];
+    prepared.size = size;
+    prepared.knobRadiusFromSize = knobRadiusFromSize;
+    prepared.fingerHoleMarginFromSize = fingerHoleMarginFromSize;
+
+    NSMutableDictionary* paths = [NSMutableDictionary dictionary];
+    if (c.mode == IKCModeRotaryDial) {
+        paths[rotaryDialPathKey(size, c.knobRadius, c.fingerHoleRadius, c.fingerHoleMargin)] =
+            CFBridgingRelease(CGPathCreateCopy(rotaryDialBezierPath(size, c.knobRadius, c.fingerHoleRadius, c.fingerHoleMargin).CGPath));
+        paths[dialStopPathKey(size)] = CFBridgingRelease(CGPathCreateCopy(dialStopBezierPath(size).CGPath));
+    }
+    else {
+        paths[knobPathKey(size, c.knobRadius)] = CFBridgingRelease(CGPathCreateCopy(knobBezierPath(size, c.knobRadius).CGPath));
+        if (c.mode == IKCModeContinuous) {
+            paths[pipPathKey(size)] = CFBridgingRelease(CGPathCreateCopy(pipBezierPath(size).CGPath));
+        }
+    }
+    prepared.paths = paths;
+
+    if ((c.mode == IKCModeLinearReturn || c.mode == IKCModeWheelOfFortune) && c.fontName) {
+        double angle = c.circular ? 2.0*M_PI : c.max - c.min;
+        CGFloat styleHeadlineSize = headlineStyleSize();
+
+        prepared.fontSizeKey = fontSizeKey(c.positions, c.fontName, angle, size.width, styleHeadlineSize);
+        prepared.fontSize = fitFontSizeForTitles(c.titles, c.positions, c.fontName, angle, size.width, styleHeadlineSize);
+
+#ifdef IKC_TITLE_RING
+        CGFloat fontSize = prepared.fontSize;
+        BOOL zooming = c.zoomTopTitle && headlinePointSize(c.zoomPointSize, fontSize) > fontSize;
+        UIColor* fillColors[4] = { [c fillColorForState:UIControlStateNormal], [c fillColorForState:UIControlStateHighlighted],
+            [c fillColorForState:UIControlStateDisabled], [c fillColorForState:UIControlStateSelected] };
+
+        if (c.rendersTitleRing && titleRingIsUsable(c.titles, zooming, fillColors)) {
+            CGSize roundedSize = CGSizeMake(floor(size.width + 0.5), floor(size.height + 0.5));
+            NSArray* strings = titleRingStrings(c.titles, c.positions);
+            IKCRingGeometry geometry = titleRingGeometry(roundedSize, scale, c.knobRadius, c.positions, c.circular, c.clockwise, c.min, c.max);
+
+            prepared.ringKey = titleRingKey(strings, c.fontName, fontSize, scale, roundedSize, c.knobRadius, c.circular, c.clockwise, c.min, c.max);
+            prepared.ringImage = CFBridgingRelease(createTitleRingImage(strings, c.fontName, fontSize * scale, geometry));
+        }
+#endif // IKC_TITLE_RING
+    }
+
+    prepared.configuration = [c copy];
+    prepared.preparationTime = CACurrentMediaTime() - start;
+
+    return prepared;
+}
+
+- (void)prepareForSize:(CGSize)size completion:(void (^)(IKCPreparedKnobConfiguration *))completion
+{
+    IKCKnobConfiguration* configuration = [self copy];
+    CGFloat scale = [UIScreen mainScreen].scale;
+
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        IKCPreparedKnobConfiguration* prepared = [configuration prepareForSize:size scale:scale];
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(prepared);
+        });
+    });
+}
+
+@end
+
+@implementation IKCMutableKnobConfiguration
+
+// implemented by IKCKnobConfiguration
+@dynamic mode, gesture, positions, titles, circular, clockwise, min, max, fontName, zoomTopTitle, zoomPointSize, knobRadius, fingerHoleRadius,
+    fingerHoleMargin, shadowColor, shadowOpacity, shadowOffset, shadowRadius;
+#ifdef IKC_TITLE_RING
+@dynamic rendersTitleRing;
+#endif // IKC_TITLE_RING
+
+- (void)setFillColor:(UIColor *)color forState:(UIControlState)state
+{
+    [self storeFillColor:color forState:state];
+}
+
+- (void)setTitleColor:(UIColor *)color forState:(UIControlState)state
+{
+    [self storeTitleColor:color forState:state];
+}
+
+@end
+
+@implementation IKCPreparedKnobConfiguration
+@end
+
+#pragma mark - IOSKnobControl implementation
+
+/*
+ * Progress of loading the image for each state from an image set, when initialized with initWithFrame:imageNamed:.
+ */
+typedef NS_ENUM(NSInteger, IKCImageLoadState) {
+    IKCImageLoadNone,
+    IKCImageLoadPending,
+    IKCImageLoadDone
+};
+
+@interface IOSKnobControl()
+/*
+ * Returns the nearest allowed position
+ */
+@property (readonly) float nearestPosition;
+@property (readonly) BOOL currentFillColorIsOpaque;
+/*
+ * Generated paths. These come from the shared IKCPathCache and are owned by it.
+ */
+@property (readonly) CGPathRef knobPath;
+@property (readonly) CGPathRef pipPath;
+@property (readonly) CGPathRef rotaryDialPath;
+@property (readonly) CGPathRef dialStopPath;
+@property (readonly) CGRect roundedBounds;
+@property (readonly) BOOL showsPlaceholder;
+@property (nonatomic, readwrite, getter=isRenderingDegraded) BOOL renderingDegraded;
+/*
+ * Whether the shadowLayer has to follow the rotation of the imageLayer
+ */
+@property (readonly) BOOL shadowLayerRotates;
+@end
+
+@implementation IOSKnobControl {
+    float touchStart, positionStart, currentTouch;
+    CGPoint gestureOrigin;
+    UIGestureRecognizer* gestureRecognizer;
+    CALayer* imageLayer, *backgroundLayer, *foregroundLayer, *middleLayer, *shadowLayer;
+    CAShapeLayer* shapeLayer, *pipLayer, *stopLayer;
+    NSMutableArray* markings, *dialMarkings;
+    UIImage* images[4];
+    UIColor* fillColor[4];
+    UIColor* titleColor[4];
+    BOOL rotating;
+    int lastNumberDialed, _numberDialed;
+    NSInteger lastPositionIndex;
+    NSString* imageSetName;
+    IKCImageLoadState imageLoadState[4];
+    NSString* fittedFontSizeKey;
+    NSArray* fittedTitles;
+    CGFloat fittedFontSize;
+    CADisplayLink* qualityMonitor;
+    CFTimeInterval lastFrameTimestamp, smoothedFrameTime, restTime;
+#ifdef IKC_SHADOW_BITMAP
+    CALayer* shadowBitmapLayer, *foregroundShadowBitmapLayer;
+#endif // IKC_SHADOW_BITMAP
+#ifdef IKC_TITLE_RING
+    CALayer* ringLayer, *ringMaskLayer, *topTitleHolder;
+    CAShapeLayer* topTitleMask;
+    IKCTextLayer* topTitleLayer;
+    NSString* ringKey, *preparedRingKey;
+    id preparedRingImage;
+#endif // IKC_TITLE_RING
+}
+
+@dynamic positionIndex, nearestPosition, knobPath, pipPath, rotaryDialPath, dialStopPath, showsPlaceholder, shadowLayerRotates;
+// readonly with custom getters, which report the current period too
+@synthesize lastDegradationDuration = _lastDegradationDuration, totalDegradationDuration = _totalDegradationDuration;
+
+#pragma mark - Path cache
+
++ (double)pathCacheHitRate
+{
+    IKCPathCache* cache = [IKCPathCache sharedCache];
+    NSUInteger lookups = cache.hits + cache.misses;
+    return lookups > 0 ? (double)cache.hits / (double)lookups : 0.0;
+}
+
++ (void)clearPathCache
+{
+    IKCPathCache* cache = [IKCPathCache sharedCache];
+    [cache removeAllPaths];
+    [cache resetStatistics];
+}
+
+#pragma mark - Object Lifecycle
+
+- (instancetype)initWithFrame:(CGRect)frame
+{
+    self = [super initWithFrame:frame];
+    if (self) {
+        [self setDefaults];
+        [self setupGestureRecognizer];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [qualityMonitor invalidate];
+}
+
+- (instancetype)initWithFrame:(CGRect)frame image:(UIImage *)image
+{
+    self = [super initWithFrame:frame];
+    if (self) {
+        [self setImage:image forState:UIControlStateNormal];
+        [self setDefaults];
+        [self setupGestureRecognizer];
+    }
+    return self;
+}
+
+- (instancetype)initWithFrame:(CGRect)frame imageNamed:(NSString *)imageSetName
+{
+    self = [super initWithFrame:frame];
+    if (self) {
+        [self setDefaults];
+        [self setupGestureRecognizer];
+
+        /*
+         * The normal image is decoded in the background with priority. The control shows a placeholder until it arrives,
+         * unless it's already been decoded (see prewarmImageSetsNamed:completion:), in which case it's applied right here.
+         * Images for the other states are only loaded when first needed. See imageForState:.
+         */
+        self->imageSetName = imageSetName;
+        [self loadImageForStateIndex:[self indexForState:UIControlStateNormal]];
+    }
+    return self;
+}
+
++ (void)prewarmImageSetsNamed:(NSArray *)imageSetNames completion:(void (^)(void))completion
+{
+    NSMutableArray* names = [NSMutableArray array];
+    for (NSString* imageSetName in imageSetNames) {
+        [names addObject:imageSetName];
+        [names addObject:[imageSetName stringByAppendingString:@"-highlighted"]];
+        [names addObject:[imageSetName stringByAppendingString:@"-disabled"]];
+        [names addObject:[imageSetName stringByAppendingString:@"-selected"]];
+    }
+
+    __block NSUInteger remaining = names.count;
+    if (remaining == 0) {
+        if (completion) completion();
+        return;
+    }
+
+    for (NSString* name in names) {
+        [[IKCImageLoader sharedLoader] loadImageNamed:name priority:DISPATCH_QUEUE_PRIORITY_LOW completion:^(UIImage* image) {
+            // always called on the main thread
+            if (--remaining == 0 && completion) completion();
+        }];
+    }
+}
+
++ (void)clearImageCache
+{
+    [[IKCImageLoader sharedLoader] removeAllImages];
+}
+
++ (void)prewarmGeometryForFrame:(CGRect)frame mode:(IKCMode)mode
+{
+    /*
+     * The same defaults as setDefaults and setMode:. knobRadius comes from the frame as passed to initWithFrame:, before
+     * rotary dial mode enlarges it.
+     */
+    CGFloat knobRadius = 0.5 * frame.size.width;
+    CGFloat fingerHoleRadius = IKC_DEFAULT_FINGER_HOLE_RADIUS;
+    CGFloat fingerHoleMargin = (knobRadius - 4.86*fingerHoleRadius)/2.93;
+    CGSize size = mode == IKCModeRotaryDial ? adjustFrame(frame, fingerHoleRadius).size : frame.size;
+
+    IKCPathCache* cache = [IKCPathCache sharedCache];
+    switch (mode) {
+        case IKCModeRotaryDial:
+            [cache pathForKey:rotaryDialPathKey(size, knobRadius, fingerHoleRadius, fingerHoleMargin) generator:^{
+                return rotaryDialBezierPath(size, knobRadius, fingerHoleRadius, fingerHoleMargin);
+            }];
+            [cache pathForKey:dialStopPathKey(size) generator:^{
+                return dialStopBezierPath(size);
+            }];
+            break;
+        case IKCModeContinuous:
+            [cache pathForKey:pipPathKey(size) generator:^{
+                return pipBezierPath(size);
+            }];
+            // fall through
+        default:
+            [cache pathForKey:knobPathKey(size, knobRadius) generator:^{
+                return knobBezierPath(size, knobRadius);
+            }];
+            break;
+    }
+}
+
+- (IKCKnobConfiguration *)configuration
+{
+    IKCMutableKnobConfiguration* configuration = [[IKCMutableKnobConfiguration alloc] init];
+    configuration.mode = _mode;
+    configuration.gesture = _gesture;
+    configuration.positions = _positions;
+    configuration.titles = _titles;
+    configuration.circular = _circular;
+    configuration.clockwise = _clockwise;
+    configuration.min = _min;
+    configuration.max = _max;
+    configuration.fontName = _fontName;
+    configuration.zoomTopTitle = _zoomTopTitle;
+    configuration.zoomPointSize = _zoomPointSize;
+    configuration.knobRadius = _knobRadius;
+    configuration.fingerHoleRadius = _fingerHoleRadius;
+    configuration.fingerHoleMargin = _fingerHoleMargin;
+    configuration.shadowColor = _shadowColor;
+    configuration.shadowOpacity = _shadowOpacity;
+    configuration.shadowOffset = _shadowOffset;
+    configuration.shadowRadius = _shadowRadius;
+#ifdef IKC_TITLE_RING
+    configuration.rendersTitleRing = _rendersTitleRing;
+#endif // IKC_TITLE_RING
+
+    // only the colors actually set. nil means derived from tintColor.
+    UIControlState states[] = { UIControlStateNormal, UIControlStateHighlighted, UIControlStateDisabled, UIControlStateSelected };
+    int j;
+    for (j=0; j<4; ++j) {
+        [configuration setFillColor:fillColor[[self indexForState:states[j]]] forState:states[j]];
+        [configuration setTitleColor:titleColor[[self indexForState:states[j]]] forState:states[j]];
+    }
+
+    return [configuration copy];
+}
+
+- (void)applyPreparedConfiguration:(IKCPreparedKnobConfiguration *)prepared
+{
+    assert([NSThread isMainThread]);
+    CFTimeInterval start = CACurrentMediaTime();
+
+    // already resolved and constrained by prepareForSize:scale:, so no need to go through the setters
+    IKCKnobConfiguration* configuration = prepared.configuration;
+    BOOL gestureChanged = configuration.gesture != _gesture;
+
+    _mode = configuration.mode;
+    _gesture = configuration.gesture;
+    _positions = configuration.positions;
+    _titles = configuration.titles;
+    _circular = configuration.circular;
+    _clockwise = configuration.clockwise;
+    _min = configuration.min;
+    _max = configuration.max;
+    if (configuration.fontName) _fontName = configuration.fontName;
+    _zoomTopTitle = configuration.zoomTopTitle;
+    _zoomPointSize = configuration.zoomPointSize;
+    _knobRadius = configuration.knobRadius;
+    _fingerHoleRadius = configuration.fingerHoleRadius;
+    _fingerHoleMargin = configuration.fingerHoleMargin;
+    _shadowColor = configuration.shadowColor;
+    _shadowOpacity = configuration.shadowOpacity;
+    _shadowOffset = configuration.shadowOffset;
+    _shadowRadius = configuration.shadowRadius;
+#ifdef IKC_TITLE_RING
+    _rendersTitleRing = configuration.rendersTitleRing;
+#endif // IKC_TITLE_RING
+
+    int j;
+    for (j=0; j<4; ++j) {
+        fillColor[j] = [configuration fillColorAtIndex:j];
+        titleColor[j] = [configuration titleColorAtIndex:j];
+    }
+
+    if (_mode == IKCModeRotaryDial) {
+        self.frame = adjustFrame(self.frame, _fingerHoleRadius);
+        lastNumberDialed = 0;
+    }
+
+    // prepared for another size. resolve the defaults against this one, as setDefaults does. the paths and ring are regenerated.
+    CGSize size = self.bounds.size;
+    if (!CGSizeEqualToSize(size, prepared.size)) {
+        if (prepared.knobRadiusFromSize) _knobRadius = 0.5 * size.width;
+        if (prepared.fingerHoleMarginFromSize) _fingerHoleMargin = (_knobRadius - 4.86*_fingerHoleRadius)/2.93;
+    }
+
+    _position = constrainPosition(_position, _circular, _normalized, _min, _max);
+
+    if (gestureChanged) [self setupGestureRecognizer];
+
+    // hand over everything computed in advance. if the size doesn't match, the keys won't either.
+    IKCPathCache* cache = [IKCPathCache sharedCache];
+    [prepared.paths enumerateKeysAndObjectsUsingBlock:^(NSString* key, id path, BOOL *stop) {
+        [cache setPath:(__bridge CGPathRef)path forKey:key];
+    }];
+
+    if (prepared.fontSizeKey) {
+        fittedFontSizeKey = prepared.fontSizeKey;
+        fittedFontSize = prepared.fontSize;
+        fittedTitles = _titles;
+    }
+
+#ifdef IKC_TITLE_RING
+    preparedRingKey = prepared.ringKey;
+    preparedRingImage = prepared.ringImage;
+#endif // IKC_TITLE_RING
+
+    // one rebuild, one commit
+    [CATransaction begin];
+    [CATransaction setDisableActions:YES];
+
+    [imageLayer removeFromSuperlayer];
+    imageLayer = nil;
+    shapeLayer = nil;
+
+    lastPositionIndex = self.positionIndex;
+    [self updateImage];
+
+    /*
+     * Text layers would otherwise only draw in the run loop's implicit commit, after the timer stops. Without the ring, that's the
+     * expensive part, so draw them here, where it's measured. It's the same work, not extra.
+     */
+    for (CALayer* layer in markings) {
+        [layer displayIfNeeded];
+    }
+    for (CALayer* layer in dialMarkings) {
+        [layer displayIfNeeded];
+    }
+#ifdef IKC_TITLE_RING
+    [topTitleLayer displayIfNeeded];
+#endif // IKC_TITLE_RING
+
+    [CATransaction commit];
+
+    _lastConfigurationApplyTime = CACurrentMediaTime() - start;
+}
+
+- (void)setDefaults
+{
+    _mode = IKCModeLinearReturn;
+    _clockwise = NO;
+    _position = 0.0;
+    _circular = YES;
+    _min = -M_PI + IKC_EPSILON;
+    _max = M_PI - IKC_EPSILON;
+    _positions = 2;
+    _timeScale = 1.0;
+    _gesture = IKCGestureOneFingerRotation;
+    _normalized = YES;
+    _fontName = @"Helvetica";
+    _shadowRadius = 3.0;
+    _shadowColor = [UIColor blackColor];
+    _shadowOpacity = 0.0;
+    _shadowOffset = CGSizeMake(0.0, 3.0);
+    _knobRadius = 0.5 * self.bounds.size.width;
+    _zoomTopTitle = YES;
+    _zoomPointSize = 0.0;
+    _drawsAsynchronously = NO;
+    _fingerHoleRadius = IKC_DEFAULT_FINGER_HOLE_RADIUS;
+    _masksImage = NO;
+    _gestureSensitivity = 1.0;
+    _adaptsRenderingQuality = NO;
+    _degradedFrameTime = 1.0/45.0;
+    _degradedShadowRadius = 1.0;
+    _degradedRasterizationScale = 0.5;
+    _qualityRestoreDuration = 0.2;
+
+    // Default margin is the same as the space between adjacent holes
+    _fingerHoleMargin = (_knobRadius - 4.86*_fingerHoleRadius)/2.93;
+
+    rotating = NO;
+    lastNumberDialed = _numberDialed = -1;
+
+    lastPositionIndex = 0;
+
+    self.opaque = NO;
+    self.backgroundColor = [UIColor clearColor];
+    self.clipsToBounds = YES;
+}
+
+#pragma mark - Public Methods, Properties and Overrides
+
+- (UIImage *)imageForState:(UIControlState)state
+{
+    int index = [self indexForState:state];
+    if (index >= 0 && !images[index] && imageLoadState[index] == IKCImageLoadNone && imageSetName) {
+        // first time we've needed this state's image. use the normal one until this one's ready.
+        [self loadImageForStateIndex:index];
+    }
+
+    /*
+     * Like UIButton, use the image for UIControlStateNormal if none present.
+     */
+    // Mmmm. Double square brackets in the last expression of the ternary conditional: outer for the array subscript, inner for a method call.
+    return index >= 0 && images[index] ? images[index] : images[[self indexForState:UIControlStateNormal]];
+}
+
+- (void)setImage:(UIImage *)image forState:(UIControlState)state
+{
+    int index = [self indexForState:state];
+    /*
+     * Don't accept mixed states here. Cannot pass, e.g., UIControlStateHighlighted & UIControlStateDisabled.
+     * Those values are ignored here.
+     */
+    if (state == UIControlStateNormal || state == UIControlStateHighlighted || state == UIControlStateDisabled || state == UIControlStateSelected) {
+        images[index] = image;
+        // an explicitly set image wins over one still loading from the image set
+        imageLoadState[index] = IKCImageLoadDone;
+    }
+
+    /*
+     * The method parameter state must be one of the four enumerated values listed above.
+     * But self.state could be a mixed state. Conceivably, the control could be
+     * both disabled and highlighted. In that case, since disabled is numerically
+     * greater than highlighted, we return the index/image for UIControlStateDisabled.
+     * (See indexForState: below.) That is to say, the following expression is always true:
+     * [self indexForState:UIControlStateDisabled] == [self indexForState:UIControlStateHighlighted|UIControlStateDisabled]
+     * If we just now changed the image currently in use (the image for the current state), update it now.
+     */
+    if (index == [self indexForState:self.state]) {
+        [self setNeedsLayout];
+    }
+}
+
+- (UIColor *)fillColorForState:(UIControlState)state
+{
+    int index = [self indexForState:state];
+    UIColor* color = index >= 0 && fillColor[index] ? fillColor[index] : fillColor[[self indexForState:UIControlStateNormal]];
+
+    if (!color) {
+        CGFloat red, green, blue, alpha;
+        [self.getTintColor getRed:&red green:&green blue:&blue alpha:&alpha];
+
+        CGFloat hue, saturation, brightness;
+        [self.getTintColor getHue:&hue saturation:&saturation brightness:&brightness alpha:&alpha];
+
+        if ((red == green && green == blue) || brightness < 0.02) {
+            /*
+             * This is for any shade of gray from black to white. Unfortunately, black is not really black.
+             * It comes out as a red hue. Hence the brightness test above.
+             */
+            CGFloat value = ((NSNumber*)@[@(0.6), @(0.8), @(0.9), @(0.8)][index]).floatValue;
+            color = [UIColor colorWithRed:value green:value blue:value alpha:alpha];
+        }
+        else {
+            saturation = ((NSNumber*)@[@(1.0), @(0.7), @(0.2), @(0.7)][index]).floatValue;
+            brightness = ((NSNumber*)@[@(0.9), @(1.0), @(0.9), @(1.0)][index]).floatValue;
+            color = [UIColor colorWithHue:hue saturation:saturation brightness:brightness alpha:alpha];
+        }
+    }
+
+    return color;
+}
+
+- (void)setFillColor:(UIColor *)color forState:(UIControlState)state
+{
+    int index = [self indexForState:state];
+    if (state == UIControlStateNormal || state == UIControlStateHighlighted || state == UIControlStateDisabled || state == UIControlStateSelected) {
+        fillColor[index] = color;
+    }
+
+    if (index == [self indexForState:self.state]) {
+        [self setNeedsLayout];
+    }
+#ifdef IKC_TITLE_RING
+    else if (_rendersTitleRing) {
+        // whether the ring can be used depends on the fill color in every state
+        [self setNeedsLayout];
+    }
+#endif // IKC_TITLE_RING
+}
+
+- (UIColor *)titleColorForState:(UIControlState)state
+{
+    int index = [self indexForState:state];
+    UIColor* color = index >= 0 && titleColor[index] ? titleColor[index] : titleColor[[self indexForState:UIControlStateNormal]];
+
+    if (!color) {
+        CGFloat red, green, blue, alpha;
+        [self.getTintColor getRed:&red green:&green blue:&blue alpha:&alpha];
+
+        CGFloat hue, saturation, brightness;
+        [self.getTintColor getHue:&hue saturation:&saturation brightness:&brightness alpha:&alpha];
+
+        if ((red == green && green == blue) || brightness < 0.02) {
+            /*
+             * This is for any shade of gray from black to white. Unfortunately, black is not really black.
+             * It comes out as a red hue. Hence the brightness test above.
+             */
+            CGFloat value = ((NSNumber*)@[@(0.25), @(0.25), @(0.4), @(0.25)][index]).floatValue;
+            color = [UIColor colorWithRed:value green:value blue:value alpha:alpha];
+        }
+        else {
+            saturation = ((NSNumber*)@[@(1.0), @(1.0), @(0.2), @(1.0)][index]).floatValue;
+            brightness = 0.5; // ((NSNumber*)@[@(0.5), @(0.5), @(0.5), @(0.5)][index]).floatValue;
+            color = [UIColor colorWithHue:hue saturation:saturation brightness:brightness alpha:alpha];
+        }
+    }
+
+    return color;
+}
+
+- (void)setTitleColor:(UIColor *)color forState:(UIControlState)state
+{
+    int index = [self indexForState:state];
+    if (state == UIControlStateNormal || state == UIControlStateHighlighted || state == UIControlStateDisabled || state == UIControlStateSelected) {
+        titleColor[index] = color;
+    }
+
+    if (index == [self indexForState:self.state]) {
+        [self setNeedsLayout];
+    }
+}
+
+- (void)setFrame:(CGRect)frame
+{
+    if (_mode == IKCModeRotaryDial)
+    {
+        frame = adjustFrame(frame, _fingerHoleRadius);
+    }
+    [super setFrame:frame];
+    [self setNeedsLayout];
+}
+
+- (void)setBackgroundImage:(UIImage *)backgroundImage
+{
+    _backgroundImage = backgroundImage;
+    [self setNeedsLayout];
+}
+
+- (void)setForegroundImage:(UIImage *)foregroundImage
+{
+    _foregroundImage = foregroundImage;
+    [self setNeedsLayout];
+}
+
+- (void)setEnabled:(BOOL)enabled
+{
+    [super setEnabled:enabled];
+    gestureRecognizer.enabled = enabled;
+
+    [self updateControlState];
 }
 
 - (void)setHighlighted:(BOOL)highlighted
@@ -720,6 +2084,18 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
     [self.layer addSublayer:imageLayer];
 }
 
+#ifdef IKC_TITLE_RING
+- (void)setRendersTitleRing:(BOOL)rendersTitleRing
+{
+    _rendersTitleRing = rendersTitleRing;
+    [imageLayer removeFromSuperlayer];
+    shapeLayer = nil;
+    imageLayer = [self createShapeLayer];
+    [self.layer addSublayer:imageLayer];
+    [self setNeedsLayout];
+}
+#endif // IKC_TITLE_RING
+
 - (void)setMode:(IKCMode)mode
 {
     _mode = mode;
@@ -746,11 +2122,11 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
     _circular = circular;
 
     if (!_circular) {
-        self.position = MIN(MAX(_position, _min), _max);
+        self.position = constrainPosition(_position, _circular, _normalized, _min, _max);
     }
-    else if (_normalized) {
-        while (_position > M_PI) _position -= 2.0 * M_PI;
-        while (_position <= -M_PI) _position += 2.0 * M_PI;
+    else {
+        // the same angle, so the knob doesn't move
+        _position = constrainPosition(_position, _circular, _normalized, _min, _max);
     }
 
     [self setNeedsLayout];
@@ -775,20 +2151,29 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
 
 - (void)setPosition:(float)position animated:(BOOL)animated
 {
-    if (_circular == NO) {
-        position = MAX(position, _min);
-        position = MIN(position, _max);
-    }
-    else if (_normalized) {
+    [self moveToPosition:position animated:animated];
+#ifdef IKC_TELEMETRY
+    [self exportTelemetryForPhase:IKCTelemetryPhaseNone];
+#endif // IKC_TELEMETRY
+}
+
+#ifdef IKC_TAPER
+- (float)value
+{
+    float normalized;
+    if (_circular) {
+        float position = _position;
         while (position > M_PI) position -= 2.0*M_PI;
         while (position <= -M_PI) position += 2.0*M_PI;
-        if (position == -M_PI) position = M_PI;
+        normalized = (position + M_PI) * 0.5 / M_PI;
     }
-    float delta = fabs(position - _position);
-
-    // ignore _timeScale. rotate through 2*M_PI in 1 s.
-    [self returnToPosition:position duration:animated ? delta*0.5/M_PI : 0.0];
+    else {
+        normalized = _max > _min ? (_position - _min) / (_max - _min) : 0.0;
+    }
+
+    return _taper ? IKCTaperEvaluate(_taper, normalized) : normalized;
 }
+#endif // IKC_TAPER
 
 - (void)setPositionIndex:(NSInteger)positionIndex
 {
@@ -874,11 +2259,11 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
     _normalized = normalized;
 
     if (!_circular) {
-        self.position = MIN(MAX(_position, _min), _max);
+        self.position = constrainPosition(_position, _circular, _normalized, _min, _max);
     }
-    else if (_normalized) {
-        while (_position > M_PI) _position -= 2.0 * M_PI;
-        while (_position <= -M_PI) _position += 2.0 * M_PI;
+    else {
+        // the same angle, so the knob doesn't move
+        _position = constrainPosition(_position, _circular, _normalized, _min, _max);
     }
 
     [self setNeedsLayout];
@@ -886,17 +2271,9 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
 
 - (void)setFontName:(NSString *)fontName
 {
-    UIFontDescriptor* fontDescriptor = [UIFontDescriptor fontDescriptorWithName:fontName size:0.0];
-    if ([fontDescriptor matchingFontDescriptorsWithMandatoryKeys:nil].count == 0) {
-        /*
-         * On iOS 6, the matchingBlah: call returns 0 for valid fonts. So we do this check too
-         * before giving up.
-         */
-        UIFontDescriptor* fontDescriptor = [UIFontDescriptor fontDescriptorWithName:fontName size:17.0];
-        if (![UIFont fontWithDescriptor:fontDescriptor size:0.0] && ![UIFont fontWithName:fontName size:17.0]) {
-            NSLog(@"Failed to find font name \"%@\".", fontName);
-            return;
-        }
+    if (!fontNameIsAvailable(fontName)) {
+        NSLog(@"Failed to find font name \"%@\".", fontName);
+        return;
     }
 
     _fontName = fontName;
@@ -939,6 +2316,14 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
     [self setNeedsLayout];
 }
 
+#ifdef IKC_SHADOW_BITMAP
+- (void)setRendersShadowBitmaps:(BOOL)rendersShadowBitmaps
+{
+    _rendersShadowBitmaps = rendersShadowBitmaps;
+    [self setNeedsLayout];
+}
+#endif // IKC_SHADOW_BITMAP
+
 - (void)setMiddleLayerShadowPath:(UIBezierPath *)middleLayerShadowPath
 {
     _middleLayerShadowPath = middleLayerShadowPath;
@@ -976,6 +2361,25 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
     [self setNeedsLayout];
 }
 
+- (void)setAdaptsRenderingQuality:(BOOL)adaptsRenderingQuality
+{
+    _adaptsRenderingQuality = adaptsRenderingQuality;
+    if (!_adaptsRenderingQuality) {
+        [self stopQualityMonitor];
+        if (_renderingDegraded) [self restoreRenderingQuality];
+    }
+}
+
+- (NSTimeInterval)lastDegradationDuration
+{
+    return _renderingDegraded ? CACurrentMediaTime() - _lastDegradationStart : _lastDegradationDuration;
+}
+
+- (NSTimeInterval)totalDegradationDuration
+{
+    return _totalDegradationDuration + (_renderingDegraded ? CACurrentMediaTime() - _lastDegradationStart : 0.0);
+}
+
 - (void)tintColorDidChange
 {
     [self setNeedsLayout];
@@ -998,49 +2402,10 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
 
 - (void)dialNumber:(int)number
 {
-    if (_mode != IKCModeRotaryDial) return;
-    if (number < 0 || number > 9) return;
-
-    lastNumberDialed = number;
-
-    if (number == 0) number = 10;
-
-    // now animate
-
-    double farPosition = (number + 1) * M_PI/6.0;
-    double adjusted = -_position;
-    while (adjusted < 0) adjusted += 2.0*M_PI;
-    double totalRotation = 2.0*farPosition - adjusted;
-
-    self.enabled = NO;
-    assert(shadowLayer.shadowPath || IKCModeRotaryDial != _mode);
-    assert(!_middleLayerShadowPath || IKCModeRotaryDial != _mode);
-    assert(middleLayer.shadowOpacity == 0.0 || IKCModeRotaryDial != _mode);
-
-    CAKeyframeAnimation *animation = [CAKeyframeAnimation animationWithKeyPath:@"transform.rotation.z"];
-    animation.values = @[@(adjusted), @(farPosition), @(0.0)];
-    animation.keyTimes = @[@(0.0), @((farPosition-adjusted)/totalRotation), @(1.0)];
-    animation.duration = _timeScale / IKC_ROTARY_DIAL_ANGULAR_VELOCITY_AT_UNIT_TIME_SCALE * totalRotation;
-    animation.timingFunction = [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionLinear];
-
-    _position = 0.0;
-
-    [CATransaction begin];
-    [CATransaction setDisableActions:YES];
-    [CATransaction setCompletionBlock:^{
-        self.enabled = YES;
-    }];
-
-    imageLayer.transform = CATransform3DMakeRotation(0.0, 0, 0, 1);
-
-    [imageLayer addAnimation:animation forKey:nil];
-
-    if (shadowLayer.shadowPath && _shadowOpacity > 0.0) {
-        shadowLayer.transform = imageLayer.transform;
-        [shadowLayer addAnimation:animation forKey:nil];
-    }
-
-    [CATransaction commit];
+    if (![self rotateToDialNumber:number]) return;
+#ifdef IKC_TELEMETRY
+    [self exportTelemetryForPhase:IKCTelemetryPhaseNone];
+#endif // IKC_TELEMETRY
 }
 
 - (void)layoutSubviews
@@ -1050,6 +2415,16 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
     [self updateImage];
 }
 
+- (void)willMoveToWindow:(UIWindow *)newWindow
+{
+    [super willMoveToWindow:newWindow];
+    if (newWindow) return;
+
+    // a gesture that never ends (e.g. followGestureSamples:count:state: with no Ended batch) would leave the display link running
+    [self stopQualityMonitor];
+    if (_renderingDegraded) [self restoreRenderingQuality];
+}
+
 #pragma mark - Private Methods: Geometry
 
 - (void)checkPositionIndex
@@ -1126,29 +2501,44 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
     return ((_max-_min)/_positions)*(positionIndex+0.5) + _min;
 }
 
-- (UIBezierPath *)rotaryDialPath
+- (CGPathRef)knobPath
 {
-    UIBezierPath* path = [UIBezierPath bezierPathWithArcCenter:CGPointMake(self.bounds.size.width*0.5, self.bounds.size.height*0.5) radius:_knobRadius startAngle:0.0 endAngle:2.0*M_PI clockwise:NO];
+    CGSize size = self.bounds.size;
+    CGFloat knobRadius = _knobRadius;
 
-    float const centerRadius = _knobRadius - _fingerHoleMargin - _fingerHoleRadius;
+    return [[IKCPathCache sharedCache] pathForKey:knobPathKey(size, knobRadius) generator:^{
+        return knobBezierPath(size, knobRadius);
+    }];
+}
 
-    int j;
-    for (j=0; j<10; ++j)
-    {
-        double centerAngle = M_PI_4 + j*M_PI/6.0;
-        double centerX = self.bounds.size.width*0.5 + centerRadius * cos(centerAngle);
-        double centerY = self.bounds.size.height*0.5 - centerRadius * sin(centerAngle);
-        [path addArcWithCenter:CGPointMake(centerX, centerY) radius:_fingerHoleRadius startAngle:M_PI_2-centerAngle endAngle:1.5*M_PI-centerAngle clockwise:YES];
-    }
-    for (--j; j>=0; --j)
-    {
-        double centerAngle = M_PI_4 + j*M_PI/6.0;
-        double centerX = self.bounds.size.width*0.5 + centerRadius * cos(centerAngle);
-        double centerY = self.bounds.size.height*0.5 - centerRadius * sin(centerAngle);
-        [path addArcWithCenter:CGPointMake(centerX, centerY) radius:_fingerHoleRadius startAngle:1.5*M_PI-centerAngle endAngle:M_PI_2-centerAngle clockwise:YES];
-    }
+- (CGPathRef)pipPath
+{
+    CGSize size = self.bounds.size;
 
-    return path;
+    return [[IKCPathCache sharedCache] pathForKey:pipPathKey(size) generator:^{
+        return pipBezierPath(size);
+    }];
+}
+
+- (CGPathRef)rotaryDialPath
+{
+    CGSize size = self.bounds.size;
+    CGFloat knobRadius = _knobRadius;
+    CGFloat fingerHoleRadius = _fingerHoleRadius;
+    CGFloat fingerHoleMargin = _fingerHoleMargin;
+
+    return [[IKCPathCache sharedCache] pathForKey:rotaryDialPathKey(size, knobRadius, fingerHoleRadius, fingerHoleMargin) generator:^{
+        return rotaryDialBezierPath(size, knobRadius, fingerHoleRadius, fingerHoleMargin);
+    }];
+}
+
+- (CGPathRef)dialStopPath
+{
+    CGSize size = self.bounds.size;
+
+    return [[IKCPathCache sharedCache] pathForKey:dialStopPathKey(size) generator:^{
+        return dialStopBezierPath(size);
+    }];
 }
 
 - (CGRect)roundedBounds
@@ -1224,6 +2614,70 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
     [self returnToPosition:nearestPositionAngle duration:duration];
 }
 
+/*
+ * Does the work of setPosition:animated: without reporting it as a programmatic change.
+ */
+- (void)moveToPosition:(float)position animated:(BOOL)animated
+{
+    position = constrainPosition(position, _circular, _normalized, _min, _max);
+    float delta = fabs(position - _position);
+
+    // ignore _timeScale. rotate through 2*M_PI in 1 s.
+    [self returnToPosition:position duration:animated ? delta*0.5/M_PI : 0.0];
+}
+
+/*
+ * Does the work of dialNumber: without reporting it as a programmatic change. Returns NO if nothing was dialed.
+ */
+- (BOOL)rotateToDialNumber:(int)number
+{
+    if (_mode != IKCModeRotaryDial) return NO;
+    if (number < 0 || number > 9) return NO;
+
+    lastNumberDialed = number;
+
+    if (number == 0) number = 10;
+
+    // now animate
+
+    double farPosition = (number + 1) * M_PI/6.0;
+    double adjusted = -_position;
+    while (adjusted < 0) adjusted += 2.0*M_PI;
+    double totalRotation = 2.0*farPosition - adjusted;
+
+    self.enabled = NO;
+    assert(shadowLayer.shadowPath || IKCModeRotaryDial != _mode);
+    assert(!_middleLayerShadowPath || IKCModeRotaryDial != _mode);
+    assert(middleLayer.shadowOpacity == 0.0 || IKCModeRotaryDial != _mode);
+
+    CAKeyframeAnimation *animation = [CAKeyframeAnimation animationWithKeyPath:@"transform.rotation.z"];
+    animation.values = @[@(adjusted), @(farPosition), @(0.0)];
+    animation.keyTimes = @[@(0.0), @((farPosition-adjusted)/totalRotation), @(1.0)];
+    animation.duration = _timeScale / IKC_ROTARY_DIAL_ANGULAR_VELOCITY_AT_UNIT_TIME_SCALE * totalRotation;
+    animation.timingFunction = [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionLinear];
+
+    restTime = MAX(restTime, CACurrentMediaTime() + animation.duration);
+    _position = 0.0;
+
+    [CATransaction begin];
+    [CATransaction setDisableActions:YES];
+    [CATransaction setCompletionBlock:^{
+        self.enabled = YES;
+    }];
+
+    imageLayer.transform = CATransform3DMakeRotation(0.0, 0, 0, 1);
+
+    [imageLayer addAnimation:animation forKey:nil];
+
+    if (self.shadowLayerRotates) {
+        shadowLayer.transform = imageLayer.transform;
+        [shadowLayer addAnimation:animation forKey:nil];
+    }
+
+    [CATransaction commit];
+    return YES;
+}
+
 - (void)returnToPosition:(float)position duration:(float)duration
 {
     if (position == _position) return;
@@ -1255,12 +2709,14 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
     animation.duration = duration;
     animation.timingFunction = [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionLinear];
 
+    restTime = MAX(restTime, CACurrentMediaTime() + duration);
+
     [CATransaction begin];
     [CATransaction setDisableActions:YES];
     [imageLayer addAnimation:animation forKey:nil];
     imageLayer.transform = CATransform3DMakeRotation(actual, 0, 0, 1);
 
-    if (shadowLayer.shadowPath && _shadowOpacity > 0.0) {
+    if (self.shadowLayerRotates) {
         [shadowLayer addAnimation:animation forKey:nil];
         shadowLayer.transform = imageLayer.transform;
     }
@@ -1317,18 +2773,7 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
         }
     }
 
-    if (currentTouch > M_PI_2 && currentTouch < M_PI && touch < -M_PI_2 && touch > -M_PI) {
-        // sudden jump from 2nd to 3rd quadrant. preserve continuity of the gesture by adjusting touchStart.
-        touchStart -= 2.0*M_PI;
-    }
-    else if (currentTouch < -M_PI_2 && currentTouch > -M_PI && touch > M_PI_2 && touch < M_PI) {
-        // sudden jump from 3rd to 2nd quadrant. preserve continuity of the gesture by adjusting touchStart.
-        touchStart += 2.0*M_PI;
-    }
-
-    float position = positionStart + touch - touchStart;
-
-    currentTouch = touch;
+    float position = positionStart + unwrapTouch(touch, &touchStart, &currentTouch);
 
     /*
     CGPoint locationInView = [sender locationInView:self];
@@ -1340,7 +2785,7 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
            sender.state == UIGestureRecognizerStateCancelled ? "cancelled" : "<misc>"), touchStart, positionStart, touch, position, _min, _max, _position);
     //*/
 
-    [self followGesture:sender toPosition:position];
+    [self followGestureInState:sender.state toPosition:position];
 }
 
 - (void)handleRotation:(UIRotationGestureRecognizer*)sender
@@ -1351,7 +2796,7 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
 
     float sign = self.clockwise ? 1.0 : -1.0;
 
-    [self followGesture:sender toPosition:positionStart + sign * sender.rotation];
+    [self followGestureInState:sender.state toPosition:positionStart + sign * sender.rotation];
 }
 
 - (void)handleVerticalPan:(UIPanGestureRecognizer*)sender
@@ -1363,7 +2808,7 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
     // 1 vertical pass over the control bounds = 1 radian
     // DEBT: Might want to make this sensitivity configurable.
     float position = positionStart - _gestureSensitivity * [sender translationInView:self].y/self.bounds.size.height;
-    [self followGesture:sender toPosition:position];
+    [self followGestureInState:sender.state toPosition:position];
 }
 
 - (void)handleTap:(UITapGestureRecognizer*)sender
@@ -1382,7 +2827,7 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
             // only rotated the image *by* a certain amount. This gesture rotates the image *to* a specific
             // position. This assumes a certain orientation of the image. For now, assume the pointer is
             // at the top.
-            self.position = position - M_PI_2;
+            [self moveToPosition:position - M_PI_2 animated:NO];
             break;
         case IKCModeLinearReturn:
         case IKCModeWheelOfFortune:
@@ -1417,24 +2862,28 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
             // image may make the finger holes any size, we allow for the largest value of 2f + m, which occurs when m = 0
             if (r < self.frame.size.width*0.294) return;
 
-            [self dialNumber:numberDialed(position)];
+            [self rotateToDialNumber:numberDialed(position)];
             [self sendActionsForControlEvents:UIControlEventValueChanged];
             break;
         default:
             break;
     }
+
+#ifdef IKC_TELEMETRY
+    [self exportTelemetryForGestureState:sender.state];
+#endif // IKC_TELEMETRY
 }
 
-- (void)followGesture:(UIGestureRecognizer*)sender toPosition:(double)position
+- (void)followGestureInState:(UIGestureRecognizerState)state toPosition:(double)position
 {
-    switch (sender.state) {
+    switch (state) {
         case UIGestureRecognizerStateCancelled:
         case UIGestureRecognizerStateEnded:
             if (self.mode == IKCModeLinearReturn || self.mode == IKCModeWheelOfFortune)
             {
                 [self snapToNearestPosition];
             }
-            else if (self.mode == IKCModeRotaryDial && sender.state == UIGestureRecognizerStateEnded)
+            else if (self.mode == IKCModeRotaryDial && state == UIGestureRecognizerStateEnded)
             {
                 double delta = currentTouch - touchStart;
                 while (delta <= -2.0*M_PI) delta += 2.0*M_PI;
@@ -1449,33 +2898,272 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
                  */
 
                 // DEBT: Review, externalize this threshold (-M_PI_4)?
-                if (_numberDialed < 0 || _numberDialed > 9 || delta > -M_PI_4 || sender.state == UIGestureRecognizerStateCancelled)
+                if (_numberDialed < 0 || _numberDialed > 9 || delta > -M_PI_4 || state == UIGestureRecognizerStateCancelled)
                 {
                     [self returnToPosition:0.0 duration:_timeScale/IKC_ROTARY_DIAL_ANGULAR_VELOCITY_AT_UNIT_TIME_SCALE*fabs(position)];
                 }
                 else
                 {
-                    [self dialNumber:_numberDialed];
+                    [self rotateToDialNumber:_numberDialed];
                     [self sendActionsForControlEvents:UIControlEventValueChanged];
                 }
             }
 
-            rotating = NO;
+            rotating = NO;
+
+            // revert from highlighted to normal
+            [self updateControlState];
+            break;
+        default:
+            // just track the touch while the gesture is in progress
+            [self moveToPosition:position animated:NO];
+            rotating = YES;
+            if (_adaptsRenderingQuality) [self startQualityMonitor];
+            break;
+    }
+
+    if (_mode != IKCModeRotaryDial)
+    {
+        [self sendActionsForControlEvents:UIControlEventValueChanged];
+    }
+
+#ifdef IKC_TELEMETRY
+    // followGestureSamples:count:state: has already exported the motion of a batch, one sample at a time
+    if (!_gestureSamples || state == UIGestureRecognizerStateEnded || state == UIGestureRecognizerStateCancelled) {
+        [self exportTelemetryForGestureState:state];
+    }
+#endif // IKC_TELEMETRY
+}
+
+/*
+ * Batches of samples go through the same tracking as handlePan:, handleRotation: and handleVerticalPan:, but only the last
+ * one reaches followGestureInState:toPosition:, so the layers are animated once and one action is sent per batch.
+ */
+- (void)followGestureSamples:(IKCGestureSample *)samples count:(NSUInteger)count state:(UIGestureRecognizerState)state
+{
+    BOOL ending = state == UIGestureRecognizerStateEnded || state == UIGestureRecognizerStateCancelled;
+    if (!self.enabled || _gesture == IKCGestureTap || (count == 0 && !ending)) return;
+
+    // everything the loop needs, so it doesn't send a message per sample
+    CGSize size = self.bounds.size;
+    CGFloat halfWidth = size.width*0.5, halfHeight = size.height*0.5;
+    BOOL clockwise = _clockwise;
+
+    if (state == UIGestureRecognizerStateBegan) {
+        CGPoint first = samples[0].location;
+        positionStart = _position;
+        gestureOrigin = first;
+        touchStart = currentTouch = atan2(halfHeight - first.y, clockwise ? halfWidth - first.x : first.x - halfWidth);
+        if (_mode == IKCModeRotaryDial) {
+            _numberDialed = numberDialed(touchStart);
+        }
+    }
+
+    float position = _position;
+    NSUInteger j;
+    for (j=0; j<count; ++j) {
+        CGPoint location = samples[j].location;
+        switch (_gesture) {
+            case IKCGestureOneFingerRotation:
+                position = positionStart + unwrapTouch(atan2(halfHeight - location.y, clockwise ? halfWidth - location.x : location.x - halfWidth), &touchStart, &currentTouch);
+                break;
+            case IKCGestureTwoFingerRotation:
+                position = positionStart + (clockwise ? 1.0 : -1.0) * samples[j].rotation;
+                break;
+            default:
+                position = positionStart - _gestureSensitivity * (location.y - gestureOrigin.y)/size.height;
+                break;
+        }
+        samples[j].position = constrainPosition(position, _circular, _normalized, _min, _max);
+    }
+
+    if (ending && count > 0 && _mode != IKCModeRotaryDial) {
+        // the built-in gestures don't move on the last callback, but the last batch may. the snap below starts from here.
+        [self returnToPosition:samples[count-1].position duration:0.0];
+    }
+
+#ifdef IKC_TELEMETRY
+    [self exportTelemetryForGestureSamples:samples count:count state:state];
+#endif // IKC_TELEMETRY
+
+    _gestureSamples = samples;
+    _gestureSampleCount = count;
+    [self followGestureInState:state toPosition:position];
+    _gestureSamples = NULL;
+    _gestureSampleCount = 0;
+}
+
+#ifdef IKC_TELEMETRY
+#pragma mark - Private Methods: Telemetry
+
+- (void)exportTelemetryForGestureState:(UIGestureRecognizerState)state
+{
+    switch (state) {
+        case UIGestureRecognizerStateBegan:
+            [self exportTelemetryForPhase:IKCTelemetryPhaseBegan];
+            break;
+        case UIGestureRecognizerStateChanged:
+            [self exportTelemetryForPhase:IKCTelemetryPhaseChanged];
+            break;
+        case UIGestureRecognizerStateEnded:
+            [self exportTelemetryForPhase:IKCTelemetryPhaseEnded];
+            break;
+        case UIGestureRecognizerStateCancelled:
+        case UIGestureRecognizerStateFailed:
+            [self exportTelemetryForPhase:IKCTelemetryPhaseCancelled];
+            break;
+        default:
+            break;
+    }
+}
+
+- (void)exportTelemetryForPhase:(IKCTelemetryPhase)phase
+{
+    [self exportTelemetryForPhase:phase position:_position timestamp:IKCTelemetryTimestamp()];
+}
+
+/*
+ * The positionIndex reported is the one the knob would have at position.
+ */
+- (void)exportTelemetryForPhase:(IKCTelemetryPhase)phase position:(float)position timestamp:(uint64_t)timestamp
+{
+    if (!_telemetryExporter) return;
+
+    IKCTelemetrySample sample;
+    sample.knobID = _telemetryID;
+    sample.position = position;
+    sample.positionIndex = (int32_t)(_mode == IKCModeContinuous ? -1 : _mode == IKCModeRotaryDial ? lastNumberDialed : [self positionIndexForPosition:position]);
+    sample.phase = phase;
+    sample.timestamp = timestamp;
+
+    // a full buffer just drops the sample. the exporter counts it.
+    IKCTelemetryExporterPush(_telemetryExporter, &sample);
+}
+
+/*
+ * One sample per IKCGestureSample, at the time of the touch rather than the time of the callback. The final state of an Ended or
+ * Cancelled batch is exported by followGestureInState:toPosition:.
+ */
+- (void)exportTelemetryForGestureSamples:(const IKCGestureSample*)samples count:(NSUInteger)count state:(UIGestureRecognizerState)state
+{
+    if (!_telemetryExporter || count == 0) return;
+
+    // sample timestamps are on the CACurrentMediaTime clock (like UITouch). move them to the clock of IKCTelemetryTimestamp.
+    int64_t offset = (int64_t)IKCTelemetryTimestamp() - (int64_t)(CACurrentMediaTime() * 1e9);
+
+    NSUInteger j;
+    for (j=0; j<count; ++j) {
+        IKCTelemetryPhase phase = j == 0 && state == UIGestureRecognizerStateBegan ? IKCTelemetryPhaseBegan : IKCTelemetryPhaseChanged;
+        [self exportTelemetryForPhase:phase position:samples[j].position timestamp:(uint64_t)((int64_t)(samples[j].timestamp * 1e9) + offset)];
+    }
+}
+#endif // IKC_TELEMETRY
+
+#pragma mark - Private Methods: Rendering Quality
+
+/*
+ * The display link runs only while the knob is moving under adaptsRenderingQuality. It serves both to measure the frame time and
+ * to notice when the knob comes to rest (gesture over, return animation finished).
+ */
+- (void)startQualityMonitor
+{
+    if (qualityMonitor) return;
+
+    lastFrameTimestamp = 0.0;
+    smoothedFrameTime = 0.0;
+
+    // DEBT: One display link per moving knob. They're cheap, and it's rare to move more than a few at once.
+    IKCWeakTarget* target = [IKCWeakTarget weakTargetWithTarget:self selector:@selector(qualityMonitorFired:)];
+    qualityMonitor = [CADisplayLink displayLinkWithTarget:target selector:@selector(displayLinkFired:)];
+    [qualityMonitor addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+}
+
+- (void)stopQualityMonitor
+{
+    // the display link only retains the IKCWeakTarget, but it stays in the run loop until invalidated
+    [qualityMonitor invalidate];
+    qualityMonitor = nil;
+}
+
+- (void)qualityMonitorFired:(CADisplayLink*)link
+{
+    if (lastFrameTimestamp > 0.0) {
+        // exponential moving average, so a single hitch doesn't count as load
+        CFTimeInterval frameTime = link.timestamp - lastFrameTimestamp;
+        smoothedFrameTime = smoothedFrameTime > 0.0 ? 0.8 * smoothedFrameTime + 0.2 * frameTime : frameTime;
+    }
+    lastFrameTimestamp = link.timestamp;
+
+    if (!rotating && CACurrentMediaTime() >= restTime) {
+        [self stopQualityMonitor];
+        if (_renderingDegraded) [self restoreRenderingQuality];
+        return;
+    }
+
+    if (rotating && !_renderingDegraded && smoothedFrameTime > _degradedFrameTime) {
+        [self degradeRenderingQuality];
+    }
+}
+
+- (void)degradeRenderingQuality
+{
+    _lastDegradationStart = CACurrentMediaTime();
+    ++ _degradationCount;
+    self.renderingDegraded = YES;
+
+    [self applyRenderingQuality];
+}
+
+- (void)restoreRenderingQuality
+{
+    CFTimeInterval duration = CACurrentMediaTime() - _lastDegradationStart;
+    _lastDegradationDuration = duration;
+    _totalDegradationDuration += duration;
+    self.renderingDegraded = NO;
+
+    // crossfade everything under the middle layer from the low-quality rendering to the full-quality one
+    CATransition* transition = [CATransition animation];
+    transition.type = kCATransitionFade;
+    transition.duration = _qualityRestoreDuration;
+    [middleLayer addAnimation:transition forKey:nil];
+
+    [self applyRenderingQuality];
+}
+
+/*
+ * Sets up the rotating layers according to renderingDegraded.
+ *
+ * Rasterizing the imageLayer flattens the knob, its titles and any mask into one bitmap, made once and then just rotated. So the mask
+ * costs nothing more while rotating and stays in place; dropping it would uncover the corners of a masked image.
+ */
+- (void)applyRenderingQuality
+{
+    [CATransaction begin];
+    [CATransaction setDisableActions:YES];
 
-            // revert from highlighted to normal
-            [self updateControlState];
-            break;
-        default:
-            // just track the touch while the gesture is in progress
-            self.position = position;
-            rotating = YES;
-            break;
+    if (_renderingDegraded) {
+        CGFloat shadowRadius = MIN(_shadowRadius, _degradedShadowRadius);
+        shadowLayer.shadowRadius = shadowRadius;
+        if (middleLayer.shadowOpacity > 0.0) {
+            // no shadow path, so the middle layer is computing the shadow from the rotating image. the smaller the better.
+            middleLayer.shadowRadius = shadowRadius;
+        }
+
+        if (_degradedRasterizationScale > 0.0) {
+            imageLayer.rasterizationScale = [UIScreen mainScreen].scale * _degradedRasterizationScale;
+            imageLayer.shouldRasterize = YES;
+        }
     }
+    else {
+        shadowLayer.shadowRadius = _shadowRadius;
+        if (middleLayer.shadowOpacity > 0.0) {
+            middleLayer.shadowRadius = _shadowRadius;
+        }
 
-    if (_mode != IKCModeRotaryDial)
-    {
-        [self sendActionsForControlEvents:UIControlEventValueChanged];
+        imageLayer.shouldRasterize = NO;
     }
+
+    [CATransaction commit];
 }
 
 #pragma mark - Private Methods: Image Management
@@ -1489,15 +3177,7 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
 
 - (UIFont*)fontWithSize:(CGFloat)fontSize
 {
-    /*
-     * Different things work in different environments, so:
-     */
-
-    UIFontDescriptor* fontDescriptor = [UIFontDescriptor fontDescriptorWithName:_fontName size:fontSize];
-    UIFont* font = [UIFont fontWithDescriptor:fontDescriptor size:0.0];
-    if (font) return font;
-
-    return [UIFont fontWithName:_fontName size:fontSize];
+    return fontWithNameAndSize(_fontName, fontSize);
 }
 
 - (UIColor*)getTintColor
@@ -1523,11 +3203,41 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
  */
 - (int)indexForState:(UIControlState)state
 {
-    if ((state & UIControlStateApplication) != 0) return -1;
-    if ((state & UIControlStateSelected) != 0) return 3;
-    if ((state & UIControlStateDisabled) != 0) return 2;
-    if ((state & UIControlStateHighlighted) != 0) return 1;
-    return 0;
+    return indexForControlState(state);
+}
+
+/*
+ * Loads the image for the state with the specified index from the image set named in initWithFrame:imageNamed:.
+ * The image set for the normal state is imageSetName. The others are imageSetName-highlighted, imageSetName-disabled
+ * and imageSetName-selected.
+ */
+- (void)loadImageForStateIndex:(int)index
+{
+    NSString* suffix = @[@"", @"-highlighted", @"-disabled", @"-selected"][index];
+    NSString* name = [imageSetName stringByAppendingString:suffix];
+    dispatch_queue_priority_t priority = index == 0 ? DISPATCH_QUEUE_PRIORITY_HIGH : DISPATCH_QUEUE_PRIORITY_DEFAULT;
+
+    imageLoadState[index] = IKCImageLoadPending;
+
+    __weak IOSKnobControl* weakSelf = self;
+    [[IKCImageLoader sharedLoader] loadImageNamed:name priority:priority completion:^(UIImage* image) {
+        IOSKnobControl* knobControl = weakSelf;
+        if (!knobControl || knobControl->imageLoadState[index] != IKCImageLoadPending) return;
+
+        knobControl->images[index] = image;
+        knobControl->imageLoadState[index] = IKCImageLoadDone;
+
+        // if this is the image (or the fallback normal image) for the current state, or we were showing the placeholder
+        [knobControl setNeedsLayout];
+    }];
+}
+
+/*
+ * While the normal image is still being decoded and there's nothing else to show
+ */
+- (BOOL)showsPlaceholder
+{
+    return !self.currentImage && imageLoadState[[self indexForState:UIControlStateNormal]] == IKCImageLoadPending;
 }
 
 /*
@@ -1603,7 +3313,31 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
     [self setDefaultMiddleLayerShadowPath];
 
     UIImage* image = self.currentImage;
-    if (image) {
+    if (self.showsPlaceholder) {
+        /*
+         * Don't build a generated knob only to throw it away when the image arrives. Nothing is known about the image
+         * yet, and a disc would flash under a transparent one (a needle, say), so the placeholder is empty.
+         */
+        if ([imageLayer isKindOfClass:CAShapeLayer.class]) {
+            [imageLayer removeFromSuperlayer];
+            imageLayer = nil;
+        }
+
+        if (!imageLayer) {
+            imageLayer = [CALayer layer];
+            imageLayer.opaque = NO;
+            imageLayer.drawsAsynchronously = _drawsAsynchronously;
+
+            float actual = self.clockwise ? self.position : -self.position;
+            imageLayer.transform = CATransform3DMakeRotation(actual, 0, 0, 1);
+
+            [middleLayer addSublayer:imageLayer];
+        }
+
+        imageLayer.contents = nil;
+        imageLayer.mask = nil;
+    }
+    else if (image) {
         if ([imageLayer isKindOfClass:CAShapeLayer.class]) {
             [imageLayer removeFromSuperlayer];
             imageLayer = nil;
@@ -1634,7 +3368,7 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
                 maskLayer.path = _middleLayerShadowPath.CGPath;
             }
             else {
-                maskLayer.path = [UIBezierPath bezierPathWithArcCenter:CGPointMake(self.bounds.size.width * 0.5, self.bounds.size.height * 0.5) radius:_knobRadius startAngle:0.0 endAngle:2.0*M_PI clockwise:NO].CGPath;
+                maskLayer.path = self.knobPath;
             }
 
             imageLayer.mask = maskLayer;
@@ -1689,11 +3423,14 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
     [self updateShapeLayer];
 
     [self setupShadowLayer];
+
+    // a layout in the middle of a gesture rebuilds the layers at full quality
+    if (_renderingDegraded) [self applyRenderingQuality];
 }
 
 - (void)updateShapeLayer
 {
-    if (!self.currentImage) {
+    if (!self.currentImage && !self.showsPlaceholder) {
         switch (_mode) {
             case IKCModeLinearReturn:
             case IKCModeWheelOfFortune:
@@ -1715,6 +3452,9 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
     for (IKCTextLayer* layer in markings) {
         layer.drawsAsynchronously = _drawsAsynchronously;
     }
+#ifdef IKC_TITLE_RING
+    topTitleLayer.drawsAsynchronously = _drawsAsynchronously;
+#endif // IKC_TITLE_RING
 
     [self updateControlState];
 }
@@ -1722,14 +3462,14 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
 - (void)setDefaultMiddleLayerShadowPath
 {
     if (_mode == IKCModeRotaryDial && !_middleLayerShadowPath) {
-        shadowLayer.shadowPath = self.rotaryDialPath.CGPath;
+        shadowLayer.shadowPath = self.rotaryDialPath;
     }
     else if (_middleLayerShadowPath) {
         shadowLayer.shadowPath = _middleLayerShadowPath.CGPath;
     }
     else if (_knobRadius > 0.0) {
         // this will be the default shadow path for any external image that doesn't override the behavior, with _knobRadius == 0.5 * self.bounds.size.width
-        shadowLayer.shadowPath = [UIBezierPath bezierPathWithArcCenter:CGPointMake(0.5*self.bounds.size.width, 0.5*self.bounds.size.height) radius:_knobRadius startAngle:0.0 endAngle:2.0*M_PI clockwise:NO].CGPath;
+        shadowLayer.shadowPath = self.knobPath;
     }
     else {
         shadowLayer.shadowPath = NULL;
@@ -1759,12 +3499,19 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
         for (IKCTextLayer* layer in markings) {
             layer.foregroundColor = self.currentTitleColor.CGColor;
         }
+
+#ifdef IKC_TITLE_RING
+        // the ring is a mask, so a new title color costs nothing
+        ringLayer.backgroundColor = self.currentTitleColor.CGColor;
+        topTitleLayer.foregroundColor = self.currentTitleColor.CGColor;
+        topTitleLayer.backgroundColor = self.currentFillColor.CGColor;
+#endif // IKC_TITLE_RING
     }
 }
 
 - (void)updateKnobWithMarkings
 {
-    shapeLayer.path = [UIBezierPath bezierPathWithArcCenter:CGPointMake(self.bounds.size.width*0.5, self.bounds.size.height*0.5) radius:_knobRadius startAngle:0.0 endAngle:2.0*M_PI clockwise:NO].CGPath;
+    shapeLayer.path = self.knobPath;
     shapeLayer.bounds = self.roundedBounds;
     shapeLayer.position = CGPointMake(self.bounds.origin.x + self.bounds.size.width * 0.5, self.bounds.origin.y + self.bounds.size.height * 0.5);
 
@@ -1772,14 +3519,23 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
         shadowLayer.shadowPath = shapeLayer.path;
     }
 
+#ifdef IKC_TITLE_RING
+    // a change of fill color, zoom or font size may have switched between the ring and separate layers
+    if (self.usesTitleRing != (ringLayer != nil)) {
+        [self addMarkings];
+    }
+    if (ringLayer) {
+        [self updateTitleRing];
+        return;
+    }
+#endif // IKC_TITLE_RING
+
     [self updateMarkings];
 }
 
 - (void)updateRotaryDial
 {
-    UIBezierPath* path = self.rotaryDialPath;
-
-    shapeLayer.path = path.CGPath;
+    shapeLayer.path = self.rotaryDialPath;
     shapeLayer.bounds = self.roundedBounds;
     shapeLayer.position = CGPointMake(self.bounds.origin.x + self.bounds.size.width * 0.5, self.bounds.origin.y + self.bounds.size.height * 0.5);
 }
@@ -1845,18 +3601,7 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
     UIFont* headlineFont = font;
     CGFloat headlinePointSize = font.pointSize;
     if (_zoomTopTitle) {
-        headlinePointSize = _zoomPointSize;
-        if (headlinePointSize == 0.0) {
-            if ([UIFontDescriptor respondsToSelector:@selector(preferredFontDescriptorWithTextStyle:)]) {
-                // iOS 7+
-                UIFontDescriptor* headlineFontDesc = [UIFontDescriptor preferredFontDescriptorWithTextStyle:UIFontTextStyleHeadline];
-                headlinePointSize = MAX(headlineFontDesc.pointSize, fontSize);
-            }
-            else {
-                // iOS 5 & 6
-                headlinePointSize = 17.0;
-            }
-        }
+        headlinePointSize = [self headlinePointSizeForFontSize:fontSize];
 
         if (headlinePointSize > fontSize) {
             headlineFont = [self fontWithSize:headlinePointSize];
@@ -1919,24 +3664,7 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
         layer.fontName = _fontName;
         layer.foregroundColor = self.currentTitleColor.CGColor;
 
-        // place it at the appropriate angle, taking the clockwise switch into account
-        float position;
-        if (self.circular) {
-            position = (2.0*M_PI/_positions)*j;
-        }
-        else {
-            position = ((_max-_min)/_positions)*(j+0.5) + _min;
-        }
-
-        float actual = _clockwise ? -position : position;
-
-        // distance from the center to place the upper left corner
-        float radius = _knobRadius - 0.5*textSize.height;
-
-        // place and rotate
-        layer.position = CGPointMake(self.bounds.origin.x + 0.5*self.bounds.size.width+radius*sin(actual), self.bounds.origin.y + 0.5*self.bounds.size.height-radius*cos(actual));
-        layer.bounds = CGRectMake(0, 0, textSize.width, textSize.height);
-        layer.transform = CATransform3DMakeRotation(actual, 0, 0, 1);
+        [self placeTitleLayer:layer atIndex:j size:textSize];
 
         /*
         layer.borderColor = self.currentTitleColor.CGColor;
@@ -1948,6 +3676,35 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
     }
 }
 
+/*
+ * Place a title layer of the specified size at the appropriate angle for position index j, taking the clockwise switch into account.
+ */
+- (void)placeTitleLayer:(CALayer*)layer atIndex:(int)j size:(CGSize)textSize
+{
+    float position;
+    if (self.circular) {
+        position = (2.0*M_PI/_positions)*j;
+    }
+    else {
+        position = ((_max-_min)/_positions)*(j+0.5) + _min;
+    }
+
+    float actual = _clockwise ? -position : position;
+
+    // distance from the center to place the upper left corner
+    float radius = _knobRadius - 0.5*textSize.height;
+
+    // place and rotate
+    layer.position = CGPointMake(self.bounds.origin.x + 0.5*self.bounds.size.width+radius*sin(actual), self.bounds.origin.y + 0.5*self.bounds.size.height-radius*cos(actual));
+    layer.bounds = CGRectMake(0, 0, textSize.width, textSize.height);
+    layer.transform = CATransform3DMakeRotation(actual, 0, 0, 1);
+}
+
+- (CGFloat)headlinePointSizeForFontSize:(CGFloat)fontSize
+{
+    return headlinePointSize(_zoomPointSize, fontSize);
+}
+
 - (void)addMarkings
 {
     for (CATextLayer* layer in markings) {
@@ -1955,6 +3712,14 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
     }
     markings = [NSMutableArray array];
 
+#ifdef IKC_TITLE_RING
+    [self removeTitleRing];
+    if (self.usesTitleRing) {
+        [self addTitleRing];
+        return;
+    }
+#endif // IKC_TITLE_RING
+
     int j;
     for (j=0; j<_positions; ++j) {
         IKCTextLayer* layer = [IKCTextLayer layer];
@@ -1964,12 +3729,159 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
     }
 }
 
+#ifdef IKC_TITLE_RING
+#pragma mark - Private Methods: Title Ring
+
+/*
+ * Attributed titles, and zoomed titles on a translucent fill, get their own layers. See titleRingIsUsable.
+ */
+- (BOOL)usesTitleRing
+{
+    if (!_rendersTitleRing) return NO;
+
+    CGFloat fontSize = self.fontSizeForTitles;
+    BOOL zooming = _zoomTopTitle && [self headlinePointSizeForFontSize:fontSize] > fontSize;
+    UIColor* fillColors[4] = { [self fillColorForState:UIControlStateNormal], [self fillColorForState:UIControlStateHighlighted],
+        [self fillColorForState:UIControlStateDisabled], [self fillColorForState:UIControlStateSelected] };
+
+    return titleRingIsUsable(_titles, zooming, fillColors);
+}
+
+/*
+ * Instead of one IKCTextLayer per position, the shapeLayer gets:
+ * - ringLayer: filled with the title color and masked by ringMaskLayer, whose contents are all the titles rendered into one
+ *   coverage bitmap on a background queue.
+ * - topTitleHolder: masked to the knob circle. Holds topTitleLayer, which draws only the zoomed top title, over its
+ *   small version in the ring.
+ */
+- (void)addTitleRing
+{
+    ringLayer = [CALayer layer];
+    ringLayer.opaque = NO;
+
+    ringMaskLayer = [CALayer layer];
+    ringMaskLayer.opaque = NO;
+    ringLayer.mask = ringMaskLayer;
+
+    topTitleLayer = [IKCTextLayer layer];
+    topTitleLayer.drawsAsynchronously = _drawsAsynchronously;
+    topTitleLayer.hidden = YES;
+
+    topTitleMask = [CAShapeLayer layer];
+    topTitleMask.fillColor = [UIColor blackColor].CGColor;
+
+    topTitleHolder = [CALayer layer];
+    topTitleHolder.opaque = NO;
+    topTitleHolder.mask = topTitleMask;
+    [topTitleHolder addSublayer:topTitleLayer];
+
+    [shapeLayer addSublayer:ringLayer];
+    [shapeLayer addSublayer:topTitleHolder];
+
+    ringKey = nil;
+}
+
+- (void)removeTitleRing
+{
+    [ringLayer removeFromSuperlayer];
+    [topTitleHolder removeFromSuperlayer];
+    ringLayer = ringMaskLayer = topTitleHolder = nil;
+    topTitleMask = nil;
+    topTitleLayer = nil;
+
+    // any render in flight will be discarded
+    ringKey = nil;
+}
+
+- (void)updateTitleRing
+{
+    CGRect bounds = self.roundedBounds;
+    CGPoint center = CGPointMake(self.bounds.size.width * 0.5, self.bounds.size.height * 0.5);
+
+    ringLayer.bounds = topTitleHolder.bounds = bounds;
+    ringLayer.position = topTitleHolder.position = center;
+    ringMaskLayer.frame = topTitleMask.frame = bounds;
+    topTitleMask.path = self.knobPath;
+
+    CGFloat fontSize = self.fontSizeForTitles;
+    CGFloat headlinePointSize = _zoomTopTitle ? [self headlinePointSizeForFontSize:fontSize] : fontSize;
+    BOOL zooming = headlinePointSize > fontSize;
+    NSInteger currentIndex = self.positionIndex;
+
+    /*
+     * usesTitleRing guarantees an opaque fill whenever the top title zooms, so the zoomed title's background hides the small
+     * one in the ring, and one ring serves every position and every state.
+     */
+    NSArray* strings = titleRingStrings(_titles, _positions);
+
+    CGFloat scale = [UIScreen mainScreen].scale;
+    NSString* key = titleRingKey(strings, _fontName, fontSize, scale, bounds.size, _knobRadius, _circular, _clockwise, _min, _max);
+    if ([key isEqualToString:preparedRingKey]) {
+        // rendered in advance by IKCKnobConfiguration
+        ringKey = key;
+        ringMaskLayer.contents = preparedRingImage;
+        preparedRingKey = nil;
+        preparedRingImage = nil;
+    }
+    else if (![key isEqualToString:ringKey]) {
+        ringKey = key;
+
+        IKCRingGeometry geometry = titleRingGeometry(bounds.size, scale, _knobRadius, _positions, _circular, _clockwise, _min, _max);
+
+        NSString* fontName = _fontName;
+        CALayer* maskLayer = ringMaskLayer;
+        __weak IOSKnobControl* weakSelf = self;
+
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            CGImageRef image = createTitleRingImage(strings, fontName, fontSize * scale, geometry);
+
+            dispatch_async(dispatch_get_main_queue(), ^{
+                IOSKnobControl* knobControl = weakSelf;
+                // discard it if anything changed in the meantime
+                if (knobControl && [knobControl->ringKey isEqualToString:key]) {
+                    maskLayer.contents = (__bridge id)image;
+                }
+                if (image) CGImageRelease(image);
+            });
+        });
+    }
+
+    topTitleLayer.hidden = !zooming;
+    if (!zooming) return;
+
+    NSString* title = strings[currentIndex];
+    UIFont* headlineFont = [self fontWithSize:headlinePointSize];
+    CGSize textSize = [title sizeOfTextWithFont:headlineFont];
+    CGFloat horizMargin = IKC_TITLE_MARGIN_RATIO * textSize.width;
+    CGFloat vertMargin = IKC_TITLE_MARGIN_RATIO * textSize.height;
+
+    textSize.width += 2.0 * horizMargin;
+    textSize.height += 2.0 * vertMargin;
+
+    topTitleLayer.string = title;
+    topTitleLayer.horizMargin = horizMargin;
+    topTitleLayer.vertMargin = vertMargin;
+    topTitleLayer.fontSize = headlinePointSize;
+    topTitleLayer.fontName = _fontName;
+    topTitleLayer.foregroundColor = self.currentTitleColor.CGColor;
+    topTitleLayer.backgroundColor = self.currentFillColor.CGColor;
+
+    [self placeTitleLayer:topTitleLayer atIndex:(int)currentIndex size:textSize];
+    [topTitleLayer setNeedsDisplay];
+}
+#endif // IKC_TITLE_RING
+
 /*
  * When no image is supplied (when [self imageForState:UIControlStateNormal] returns nil),
  * use a CAShapeLayer instead.
  */
 - (CAShapeLayer*)createShapeLayer
 {
+#ifdef IKC_TITLE_RING
+    // the ring lives in the old shapeLayer. createKnobWithMarkings makes a new one if appropriate.
+    [self removeTitleRing];
+#endif // IKC_TITLE_RING
+
     switch (_mode)
     {
         case IKCModeContinuous:
@@ -1998,7 +3910,7 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
 - (CAShapeLayer*)createKnobWithPip
 {
     shapeLayer = [CAShapeLayer layer];
-    shapeLayer.path = [UIBezierPath bezierPathWithArcCenter:CGPointMake(self.bounds.size.width*0.5, self.bounds.size.height*0.5) radius:_knobRadius startAngle:0.0 endAngle:2.0*M_PI clockwise:NO].CGPath;
+    shapeLayer.path = self.knobPath;
     shapeLayer.bounds = self.roundedBounds;
     shapeLayer.position = CGPointMake(self.bounds.origin.x + self.bounds.size.width * 0.5, self.bounds.origin.y + self.bounds.size.height * 0.5);
     shapeLayer.backgroundColor = [UIColor clearColor].CGColor;
@@ -2016,7 +3928,7 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
     markings = nil;
 
     pipLayer = [CAShapeLayer layer];
-    pipLayer.path = [UIBezierPath bezierPathWithArcCenter:CGPointMake(self.bounds.size.width*0.5, self.bounds.size.height*0.08) radius:self.bounds.size.width*0.03 startAngle:0.0 endAngle:2.0*M_PI clockwise:NO].CGPath;
+    pipLayer.path = self.pipPath;
     pipLayer.bounds = self.roundedBounds;
     pipLayer.position = CGPointMake(self.bounds.origin.x + self.bounds.size.width * 0.5, self.bounds.origin.y + self.bounds.size.height * 0.5);
     pipLayer.opaque = NO;
@@ -2079,33 +3991,8 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
 
 - (CALayer*)createDialStop
 {
-    float const stopWidth = 0.05;
-
-    // the stop is an isosceles triangle at 4:00 (-M_PI/6) pointing inward radially.
-
-    // the near point is the point nearest the center of the dial, at the edge of the
-    // outer tap ring. (see handleTap: for where the 0.586 comes from.)
-
-    float nearX = self.bounds.size.width*0.5 * (1.0 + 0.586 * sqrt(3.0) * 0.5);
-    float nearY = self.bounds.size.height*0.5 * (1.0 + 0.586 * 0.5);
-
-    // the opposite edge is tangent to the perimeter of the dial. the width of the far side
-    // is stopWidth * self.frame.size.height * 0.5.
-
-    float upperEdgeX = self.bounds.size.width*0.5 * (1.0 + sqrt(3.0) * 0.5 + stopWidth * 0.5);
-    float upperEdgeY = self.bounds.size.height*0.5 * (1.0 + 0.5 - stopWidth * sqrt(3.0)*0.5);
-
-    float lowerEdgeX = self.bounds.size.width*0.5 * (1.0 + sqrt(3.0) * 0.5 - stopWidth * 0.5);
-    float lowerEdgeY = self.bounds.size.height*0.5 * (1.0 + 0.5 + stopWidth * sqrt(3.0)*0.5);
-
-    UIBezierPath* path = [UIBezierPath bezierPath];
-    [path moveToPoint:CGPointMake(nearX, nearY)];
-    [path addLineToPoint:CGPointMake(lowerEdgeX, lowerEdgeY)];
-    [path addLineToPoint:CGPointMake(upperEdgeX, upperEdgeY)];
-    [path closePath];
-
     stopLayer = [CAShapeLayer layer];
-    stopLayer.path = path.CGPath;
+    stopLayer.path = self.dialStopPath;
     stopLayer.position = CGPointMake(self.bounds.origin.x + self.bounds.size.width * 0.5, self.bounds.origin.y + self.bounds.size.height * 0.5);
     stopLayer.bounds = self.roundedBounds;
     stopLayer.backgroundColor = [UIColor clearColor].CGColor;
@@ -2155,10 +4042,13 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
     // should always have a shadow path with rotary dial
     assert(shadowLayer.shadowPath || _mode != IKCModeRotaryDial);
 
+    // no shadow under the empty placeholder either
+    float shadowOpacity = self.showsPlaceholder ? 0.0 : _shadowOpacity;
+
     // Set by [self setDefaultMiddleLayerShadowPath]
     if (shadowLayer.shadowPath != NULL) {
         shadowLayer.shadowOffset = CGSizeZero;
-        shadowLayer.shadowOpacity = _shadowOpacity;
+        shadowLayer.shadowOpacity = shadowOpacity;
         shadowLayer.shadowColor = _shadowColor.CGColor;
         shadowLayer.shadowRadius = _shadowRadius;
         // shadowLayer.position set in updateImage, with bounds
@@ -2168,66 +4058,220 @@ static CGRect adjustFrame(CGRect frame, CGFloat fingerHoleRadius) {
         middleLayer.shadowOffset = _shadowOffset;
         middleLayer.shadowColor = _shadowColor.CGColor;
         middleLayer.shadowRadius = _shadowRadius;
-        middleLayer.shadowOpacity = _shadowOpacity;
+        middleLayer.shadowOpacity = shadowOpacity;
         shadowLayer.shadowOpacity = 0.0;
     }
+
+#ifdef IKC_SHADOW_BITMAP
+    [self updateShadowBitmaps];
+#endif // IKC_SHADOW_BITMAP
 }
 
-- (CGFloat)titleCircumferenceWithFont:(UIFont*)font
+- (BOOL)shadowLayerRotates
 {
-    CGFloat max = 0.0;
-    for (id titleObject in _titles) {
+#ifdef IKC_SHADOW_BITMAP
+    if (shadowBitmapLayer) return YES;
+#endif // IKC_SHADOW_BITMAP
+    return shadowLayer.shadowPath && _shadowOpacity > 0.0;
+}
 
-        CGSize textSize = CGSizeZero;
-        if ([titleObject isKindOfClass:NSAttributedString.class]) {
-            NSAttributedString* attributed = (NSAttributedString*)titleObject;
-            textSize = attributed.size;
-        }
-        else if ([titleObject isKindOfClass:NSString.class]) {
-            textSize = [(NSString*)titleObject sizeOfTextWithFont:font];
-            // NSLog(@"textSize: %f x %f", textSize.width, textSize.height);
+#ifdef IKC_SHADOW_BITMAP
+/*
+ * Replaces the live shadows set up by setupShadowLayer and updateImage with precomputed bitmaps, when rendersShadowBitmaps is set.
+ *
+ * The knob's shadow goes in a sublayer of the shadowLayer, which is already offset by shadowOffset and rotates with the knob. So a
+ * circular knob just rotates a bitmap nobody can tell is rotating, and a rotary dial or a custom image rotates its own shadow with it.
+ * Without a shadow path, the outline comes from the current image, which used to mean the middleLayer computing a shadow from the
+ * rotating image every frame.
+ *
+ * The foreground's shadow goes in a separate layer just below the foregroundLayer, since a sublayer would be drawn over its contents.
+ */
+- (void)updateShadowBitmaps
+{
+    BOOL enabled = _rendersShadowBitmaps && _shadowOpacity > 0.0 && !self.showsPlaceholder;
+    CGRect bounds = self.roundedBounds;
+
+    CGPathRef path = shadowLayer.shadowPath;
+    CGImageRef image = path ? NULL : self.currentImage.CGImage;
+    if (enabled && (path || image)) {
+        shadowLayer.shadowOpacity = 0.0;
+        middleLayer.shadowOpacity = 0.0;
+
+        if (!shadowBitmapLayer) {
+            shadowBitmapLayer = [CALayer layer];
+            shadowBitmapLayer.opaque = NO;
+            [shadowLayer addSublayer:shadowBitmapLayer];
         }
-        CGFloat width = textSize.width * (1.0 + 2.0 * IKC_TITLE_MARGIN_RATIO);
-        max = MAX(max, width);
+
+        [CATransaction begin];
+        [CATransaction setDisableActions:YES];
+        // without a shadow path, the shadowLayer didn't have to rotate until now
+        shadowLayer.transform = imageLayer.transform;
+        shadowBitmapLayer.position = CGPointMake(bounds.size.width * 0.5, bounds.size.height * 0.5);
+        [CATransaction commit];
+
+        [self loadShadowBitmapIntoLayer:shadowBitmapLayer path:path image:image];
+    }
+    else {
+        [shadowBitmapLayer removeFromSuperlayer];
+        shadowBitmapLayer = nil;
     }
 
-    return max * _positions;
+    path = foregroundLayer.shadowPath;
+    image = path ? NULL : _foregroundImage.CGImage;
+    if (enabled && foregroundLayer && (path || image)) {
+        foregroundLayer.shadowOpacity = 0.0;
+
+        if (!foregroundShadowBitmapLayer) {
+            foregroundShadowBitmapLayer = [CALayer layer];
+            foregroundShadowBitmapLayer.opaque = NO;
+        }
+
+        // updateImage makes a new foregroundLayer each time
+        [self.layer insertSublayer:foregroundShadowBitmapLayer below:foregroundLayer];
+
+        [CATransaction begin];
+        [CATransaction setDisableActions:YES];
+        foregroundShadowBitmapLayer.position = CGPointMake(bounds.size.width * 0.5 + _shadowOffset.width, bounds.size.height * 0.5 + _shadowOffset.height);
+        [CATransaction commit];
+
+        [self loadShadowBitmapIntoLayer:foregroundShadowBitmapLayer path:path image:image];
+    }
+    else {
+        [foregroundShadowBitmapLayer removeFromSuperlayer];
+        foregroundShadowBitmapLayer = nil;
+    }
 }
 
-- (CGFloat)fontSizeForTitles
+/*
+ * Sets the contents of the layer to the shadow of the outline with the current settings, from the shared cache or, if not there yet,
+ * when rendered on a background queue. The key of the shadow the layer should show is kept in the layer itself.
+ */
+- (void)loadShadowBitmapIntoLayer:(CALayer*)layer path:(CGPathRef)path image:(CGImageRef)image
 {
-    CGFloat styleHeadlineSize = 17.0;
+    CGSize size = self.roundedBounds.size;
+    CGFloat scale = [UIScreen mainScreen].scale;
+    CGFloat radius = _shadowRadius;
+    CGFloat opacity = _shadowOpacity;
 
-    if ([UIFontDescriptor respondsToSelector:@selector(preferredFontDescriptorWithTextStyle:)]) {
-        styleHeadlineSize = [UIFontDescriptor preferredFontDescriptorWithTextStyle:UIFontTextStyleHeadline].pointSize;
+    CGFloat red, green, blue, alpha;
+    if (![_shadowColor getRed:&red green:&green blue:&blue alpha:&alpha]) {
+        // not an RGB color (e.g. a pattern). fall back to black.
+        red = green = blue = 0.0;
+        alpha = 1.0;
     }
-    // NSLog(@"Size of headline style: %f", styleHeadlineSize);
 
-    double angle = _circular ? 2.0*M_PI : _max - _min;
+    /*
+     * Paths are identified by content: generated paths by their IKCPathCache key, client paths by a hash of their elements. An image
+     * is identified by address, so the layer and the cache entry retain it. That way the address can't be reused for another image
+     * while either one identifies it.
+     */
+    NSString* outlineKey;
+    id source = nil;
+    if (path) {
+        outlineKey = [[IKCPathCache sharedCache] keyForPath:path] ?: pathContentKey(path);
+    }
+    else {
+        source = (__bridge id)image;
+        outlineKey = [NSString stringWithFormat:@"image:%p", image];
+    }
 
-    CGFloat fontSize;
-    for (fontSize = 23.0; fontSize >= 7.0; fontSize -= 1.0) {
-        if (fontSize > styleHeadlineSize) {
-            // don't display anything larger than the current headline size (max. 23 pts.)
-            continue;
+    NSString* key = [NSString stringWithFormat:@"%@:%f:%f:%f:%f:%f:%f:%f:%f:%f", outlineKey, size.width, size.height, scale, radius, red, green, blue, alpha, opacity];
+    if ([[layer valueForKey:@"IKCShadowKey"] isEqualToString:key]) return;
+    [layer setValue:key forKey:@"IKCShadowKey"];
+    [layer setValue:source forKey:@"IKCShadowSource"];
+
+    NSCache* cache = shadowImageCache();
+    NSArray* entry = [cache objectForKey:key];
+    if (entry) {
+        [self setShadowEntry:entry onLayer:layer];
+        return;
+    }
+
+    layer.contents = nil;
+
+    // keep the outline alive for the block
+    id pathObject = path ? CFBridgingRelease(CGPathCreateCopy(path)) : nil;
+    id imageObject = source;
+    __weak IOSKnobControl* weakSelf = self;
+
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        CGFloat rgba[] = { red, green, blue, alpha };
+        CGFloat padding = 0.0;
+        CGImageRef shadow = createShadowImage((__bridge CGPathRef)pathObject, (__bridge CGImageRef)imageObject, size, scale, radius, rgba, opacity, &padding);
+        if (!shadow) {
+            // nothing is cached, so the next update tries again
+            dispatch_async(dispatch_get_main_queue(), ^{
+                if ([[layer valueForKey:@"IKCShadowKey"] isEqualToString:key]) {
+                    [weakSelf restoreLiveShadowForLayer:layer];
+                }
+            });
+            return;
         }
 
-        // NSLog(@"Looking for font %@ %f", _fontName, fontSize);
-        UIFont* font = [self fontWithSize:fontSize];
-        if (!font) {
-            // Assume it will eventually find one.
-            continue;
+        NSArray* entry = @[CFBridgingRelease(shadow), @(padding), imageObject ?: [NSNull null]];
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [cache setObject:entry forKey:key];
+
+            // unless the settings changed in the meantime
+            if ([[layer valueForKey:@"IKCShadowKey"] isEqualToString:key]) {
+                [weakSelf setShadowEntry:entry onLayer:layer];
+            }
+        });
+    });
+}
+
+/*
+ * When a bitmap couldn't be rendered, goes back to the Core Animation shadow that setupShadowLayer or updateImage set up.
+ */
+- (void)restoreLiveShadowForLayer:(CALayer*)layer
+{
+    float shadowOpacity = self.showsPlaceholder ? 0.0 : _shadowOpacity;
+
+    if (layer == shadowBitmapLayer) {
+        [shadowBitmapLayer removeFromSuperlayer];
+        shadowBitmapLayer = nil;
+
+        if (shadowLayer.shadowPath) {
+            shadowLayer.shadowOpacity = shadowOpacity;
+        }
+        else {
+            middleLayer.shadowOpacity = shadowOpacity;
         }
+    }
+    else if (layer == foregroundShadowBitmapLayer) {
+        [foregroundShadowBitmapLayer removeFromSuperlayer];
+        foregroundShadowBitmapLayer = nil;
+        foregroundLayer.shadowOpacity = shadowOpacity;
+    }
+}
+
+- (void)setShadowEntry:(NSArray*)entry onLayer:(CALayer*)layer
+{
+    CGFloat padding = [entry[1] doubleValue];
+    CGSize size = self.roundedBounds.size;
 
-        CGFloat circumference = [self titleCircumferenceWithFont:font];
+    layer.bounds = CGRectMake(0, 0, size.width + 2.0 * padding, size.height + 2.0 * padding);
+    layer.contents = entry[0];
+}
+#endif // IKC_SHADOW_BITMAP
 
-        // NSLog(@"With font size %f: circumference %f/%f", fontSize, circumference, angle*self.bounds.size.width*0.25);
+/*
+ * Fitting the titles measures every title at up to 17 sizes, so the result is kept until something it depends on changes.
+ */
+- (CGFloat)fontSizeForTitles
+{
+    double angle = _circular ? 2.0*M_PI : _max - _min;
+    CGFloat styleHeadlineSize = headlineStyleSize();
+    NSString* key = fontSizeKey(_positions, _fontName, angle, self.bounds.size.width, styleHeadlineSize);
 
-        // Empirically, this factor works out well. This allows for a little padding between text segments.
-        if (circumference <= angle*self.bounds.size.width*0.4) break;
+    if (![key isEqualToString:fittedFontSizeKey] || (_titles != fittedTitles && ![_titles isEqualToArray:fittedTitles])) {
+        fittedFontSize = fitFontSizeForTitles(_titles, _positions, _fontName, angle, self.bounds.size.width, styleHeadlineSize);
+        fittedFontSizeKey = key;
+        fittedTitles = [_titles copy];
     }
 
-    return fontSize;
+    return fittedFontSize;
 }
 
 @end
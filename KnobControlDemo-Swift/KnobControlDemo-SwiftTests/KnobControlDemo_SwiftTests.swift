@@ -25,10 +25,57 @@ class KnobControlDemo_SwiftTests: XCTestCase {
         XCTAssert(true, "Pass")
     }
     
-    func testPerformanceExample() {
-        // This is an example of a performance test case.
-        self.measureBlock() {
-            // Put the code you want to measure the time of here.
+    // MARK: - Startup with image-backed knobs
+
+    let knobCount = 48
+
+    // none of these has -highlighted, -disabled or -selected variants, so each knob decodes exactly one image
+    let imageSetNames = ["needle", "tonearm", "hexagon-cw", "hexagon-ccw"]
+
+    /*
+     * Builds a screen full of knobs with initWithFrame:imageNamed: and waits until every one of them has its image.
+     */
+    private func buildKnobsAndWaitForImages() {
+        let container = UIView(frame: CGRectMake(0, 0, 320, 480))
+        for j in 0..<knobCount {
+            let frame = CGRectMake(CGFloat(j % 6) * 52, CGFloat(j / 6) * 52, 48, 48)
+            let knobControl = IOSKnobControl(frame: frame, imageNamed: imageSetNames[j % imageSetNames.count])
+            container.addSubview(knobControl)
+        }
+        container.layoutIfNeeded()
+
+        // requests for an image that is already being decoded share that decode, so this completes once every knob has its image
+        let loaded = expectationWithDescription("images decoded")
+        IOSKnobControl.prewarmImageSetsNamed(imageSetNames) {
+            loaded.fulfill()
+        }
+        waitForExpectationsWithTimeout(10.0, handler: nil)
+
+        // the knobs apply their images on the next layout
+        container.layoutIfNeeded()
+    }
+
+    func testPerformanceStartupWithoutPrewarming() {
+        measureBlock() {
+            IOSKnobControl.clearImageCache()
+            self.buildKnobsAndWaitForImages()
+        }
+    }
+
+    func testPerformanceStartupWithPrewarming() {
+        measureMetrics(KnobControlDemo_SwiftTests.defaultPerformanceMetrics(), automaticallyStartMeasuring: false) {
+            IOSKnobControl.clearImageCache()
+
+            // what an app does during launch, before it builds the screen
+            let prewarmed = self.expectationWithDescription("image sets prewarmed")
+            IOSKnobControl.prewarmImageSetsNamed(self.imageSetNames) {
+                prewarmed.fulfill()
+            }
+            self.waitForExpectationsWithTimeout(10.0, handler: nil)
+
+            self.startMeasuring()
+            self.buildKnobsAndWaitForImages()
+            self.stopMeasuring()
         }
     }
     
@@ -0,0 +1,143 @@
+/*
+ iOS Knob Control
+ Copyright (c) 2013-14, Jimmy Dee
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Benchmark for IKCRing.c. Runs anywhere with a C99 compiler; see the Makefile.
+ *
+ * Lays out and composites 12, 24 and 60 synthetic titles around a 240-point knob at 3x, the way the control does when
+ * rendersTitleRing is set, and reports the time per ring next to the number of layers Core Animation composites each frame
+ * with the ring (the ring plus the zoomed top title) and without it (one IKCTextLayer per title).
+ */
+
+// clock_gettime and CLOCK_MONOTONIC
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "IKCRing.h"
+
+#define KNOB_SIZE 240
+#define SCALE 3
+#define MAX_TITLES 60
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/*
+ * Fills a title with vertical strokes and antialiased edges, roughly the coverage of rasterized text, sized so that count
+ * titles fit around the ring the way fontSizeForTitles fits them.
+ */
+static void makeTitle(IKCGlyphBitmap* title, uint8_t* alpha, int count, float radius)
+{
+    float arc = 2.0f * 3.14159265f * radius / count;
+    int width = (int)(0.7f * arc);
+    if (width > 40 * SCALE) width = 40 * SCALE;
+    int height = (int)(0.45f * width);
+
+    int x, y;
+    for (y=0; y<height; ++y) {
+        for (x=0; x<width; ++x) {
+            int phase = x % 9;
+            alpha[y * width + x] = phase < 3 ? 255 : phase == 3 ? 128 : 0;
+        }
+    }
+
+    title->alpha = alpha;
+    title->width = width;
+    title->height = height;
+    title->stride = (size_t)width;
+}
+
+static int benchmarkRing(unsigned count)
+{
+    IKCRingGeometry geometry;
+    memset(&geometry, 0, sizeof(geometry));
+    geometry.width = geometry.height = KNOB_SIZE * SCALE;
+    geometry.radius = 0.5f * KNOB_SIZE * SCALE;
+    geometry.positions = count;
+    geometry.circular = 1;
+    geometry.clockwise = 0;
+
+    IKCGlyphBitmap titles[MAX_TITLES];
+    IKCRingPlacement placements[MAX_TITLES];
+    uint8_t* glyphs = malloc((size_t)40 * SCALE * 40 * SCALE);
+    size_t const stride = (size_t)geometry.width;
+    uint8_t* ring = malloc(stride * geometry.height);
+    if (!glyphs || !ring) {
+        free(glyphs);
+        free(ring);
+        return -1;
+    }
+
+    // every title shares the same pixels. only the size matters to the compositor.
+    unsigned j;
+    makeTitle(&titles[0], glyphs, count, geometry.radius);
+    for (j=1; j<count; ++j) titles[j] = titles[0];
+
+    int repetitions = 0;
+    double layout = 0.0, composite = 0.0;
+    while (layout + composite < 0.5) {
+        memset(ring, 0, stride * geometry.height);
+
+        double start = now();
+        IKCRingLayout(&geometry, titles, count, placements);
+        double laidOut = now();
+        IKCRingComposite(ring, stride, &geometry, titles, placements, count);
+        double end = now();
+
+        layout += laidOut - start;
+        composite += end - laidOut;
+        ++ repetitions;
+    }
+
+    // total coverage of the last ring, so the work can't be optimized away
+    size_t k, coverage = 0;
+    for (k=0; k<stride * geometry.height; ++k) coverage += ring[k];
+
+    // each text layer has its own backing store, 4 bytes per pixel. the ring is 8-bit coverage.
+    size_t const perTitleBytes = (size_t)count * titles[0].width * titles[0].height * 4;
+    size_t const ringBytes = stride * geometry.height;
+
+    printf("%2u titles:  layout %6.1f us  composite %7.1f us  (coverage %zu)\n", count, layout / repetitions * 1e6,
+           composite / repetitions * 1e6, coverage / 255);
+    printf("            layers: ring 2 (ring + zoomed title), per title %u    backing: ring %zu KB, per title %zu KB\n",
+           count, ringBytes / 1024, perTitleBytes / 1024);
+
+    free(glyphs);
+    free(ring);
+    return 0;
+}
+
+int main(void)
+{
+    static const unsigned counts[] = { 12, 24, 60 };
+    size_t j;
+    for (j=0; j<sizeof(counts)/sizeof(counts[0]); ++j) {
+        if (benchmarkRing(counts[j])) {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+    }
+    return 0;
+}
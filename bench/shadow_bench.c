@@ -0,0 +1,216 @@
+/*
+ iOS Knob Control
+ Copyright (c) 2013-14, Jimmy Dee
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Accuracy check and benchmark for IKCShadow.c. Runs anywhere with a C99 compiler; see the Makefile.
+ *
+ * Blurs a filled disc, padded by IKCShadowPadding, with IKCShadowBlur and with a direct separable Gaussian for several sigmas,
+ * and reports the worst and RMS differences in coverage levels and the change in total coverage. Then reports the throughput
+ * of IKCShadowBlur on raw buffers at typical mask sizes.
+ */
+
+// clock_gettime and CLOCK_MONOTONIC
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "IKCShadow.h"
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/*
+ * A disc of the given radius, antialiased over one pixel, centered in a square mask with room for the blur.
+ */
+static uint8_t* createDisc(int radius, float sigma, int* size)
+{
+    int const padding = IKCShadowPadding(sigma);
+    int const width = 2 * (radius + padding);
+    uint8_t* mask = malloc((size_t)width * width);
+    if (!mask) return NULL;
+
+    int x, y;
+    for (y=0; y<width; ++y) {
+        for (x=0; x<width; ++x) {
+            double dx = x + 0.5 - 0.5 * width;
+            double dy = y + 0.5 - 0.5 * width;
+            double coverage = radius + 0.5 - sqrt(dx * dx + dy * dy);
+            mask[y * width + x] = coverage >= 1.0 ? 255 : coverage <= 0.0 ? 0 : (uint8_t)(255.0 * coverage + 0.5);
+        }
+    }
+
+    *size = width;
+    return mask;
+}
+
+/*
+ * Reference: a sampled Gaussian truncated at 4 sigma and normalized, applied separably in double precision. Pixels outside
+ * the mask count as 0, as in IKCShadowBlur.
+ */
+static double* gaussianBlur(const uint8_t* mask, int size, float sigma)
+{
+    int const reach = (int)ceil(4.0 * sigma);
+    double* kernel = malloc((2 * reach + 1) * sizeof(double));
+    double* rows = malloc((size_t)size * size * sizeof(double));
+    double* result = malloc((size_t)size * size * sizeof(double));
+    if (!kernel || !rows || !result) {
+        free(kernel);
+        free(rows);
+        free(result);
+        return NULL;
+    }
+
+    double total = 0.0;
+    int j, x, y;
+    for (j=-reach; j<=reach; ++j) total += kernel[j + reach] = exp(-0.5 * j * j / ((double)sigma * sigma));
+    for (j=0; j<=2*reach; ++j) kernel[j] /= total;
+
+    for (y=0; y<size; ++y) {
+        for (x=0; x<size; ++x) {
+            double sum = 0.0;
+            for (j=-reach; j<=reach; ++j) {
+                if (x + j >= 0 && x + j < size) sum += kernel[j + reach] * mask[y * size + x + j];
+            }
+            rows[y * size + x] = sum;
+        }
+    }
+
+    for (y=0; y<size; ++y) {
+        for (x=0; x<size; ++x) {
+            double sum = 0.0;
+            for (j=-reach; j<=reach; ++j) {
+                if (y + j >= 0 && y + j < size) sum += kernel[j + reach] * rows[(y + j) * size + x];
+            }
+            result[y * size + x] = sum;
+        }
+    }
+
+    free(kernel);
+    free(rows);
+    return result;
+}
+
+static int checkAccuracy(float sigma)
+{
+    int size;
+    uint8_t* mask = createDisc(60, sigma, &size);
+    if (!mask) return -1;
+
+    double* expected = gaussianBlur(mask, size, sigma);
+    if (!expected) {
+        free(mask);
+        return -1;
+    }
+
+    double before = 0.0;
+    size_t k, count = (size_t)size * size;
+    for (k=0; k<count; ++k) before += mask[k];
+
+    if (IKCShadowBlur(mask, size, size, size, sigma, NULL)) {
+        free(expected);
+        free(mask);
+        return -1;
+    }
+
+    double after = 0.0, worst = 0.0, squares = 0.0;
+    for (k=0; k<count; ++k) {
+        double error = fabs(mask[k] - expected[k]);
+        if (error > worst) worst = error;
+        squares += error * error;
+        after += mask[k];
+    }
+
+    double massError = fabs(after - before) / before;
+    printf("sigma %4.1f:  vs Gaussian worst %4.1f RMS %.2f levels of 255, mass %+.3f%%\n", sigma, worst, sqrt(squares / count),
+           100.0 * (after - before) / before);
+
+    free(expected);
+    free(mask);
+
+    /*
+     * Three boxes are not a Gaussian, but the shadow must look like one and be no lighter or darker overall. Below about 1.5
+     * pixels the boxes are only 1 and 3 pixels wide, so the shape is only checked above that.
+     */
+    return (sigma < 1.5f || worst <= 6.0) && massError <= 0.005 ? 0 : -1;
+}
+
+/*
+ * A mask the size IOSKnobControl blurs for a knob of the given size and shadowRadius, both in points.
+ */
+static int benchmarkBlur(int points, int scale, float shadowRadius)
+{
+    float const sigma = shadowRadius * scale;
+    int const width = points * scale + 2 * IKCShadowPadding(sigma);
+    int const height = width;
+    size_t const stride = (size_t)width;
+    uint8_t* mask = malloc(stride * height);
+    void* scratch = malloc(IKCShadowScratchSize(width, height));
+    if (!mask || !scratch) {
+        free(mask);
+        free(scratch);
+        return -1;
+    }
+
+    int repetitions = 0;
+    double elapsed = 0.0;
+    while (elapsed < 0.3) {
+        // the blur works in place, so start each run from the same sharp mask
+        memset(mask, 0, stride * height);
+        int y;
+        for (y=height/4; y<3*height/4; ++y) memset(mask + y * stride + width/4, 255, width/2);
+
+        double start = now();
+        IKCShadowBlur(mask, width, height, stride, sigma, scratch);
+        elapsed += now() - start;
+        ++ repetitions;
+    }
+
+    printf("%3d pt at %dx, shadowRadius %.0f (%4d x %4d px):  %6.1f Mpix/s  (%.0f us per mask)\n", points, scale, shadowRadius, width, height,
+           (double)width * height * repetitions / elapsed / 1e6, elapsed / repetitions * 1e6);
+
+    free(mask);
+    free(scratch);
+    return 0;
+}
+
+int main(void)
+{
+    static const float sigmas[] = { 1.0f, 2.0f, 3.0f, 6.0f, 9.0f, 16.0f, 32.0f };
+    size_t j;
+    for (j=0; j<sizeof(sigmas)/sizeof(sigmas[0]); ++j) {
+        if (checkAccuracy(sigmas[j])) {
+            fprintf(stderr, "accuracy check failed\n");
+            return 1;
+        }
+    }
+
+    // small and large knobs at 2x and 3x, with the default shadowRadius and a heavy one
+    if (benchmarkBlur(100, 2, 3.0f) || benchmarkBlur(100, 2, 8.0f) || benchmarkBlur(240, 3, 3.0f) || benchmarkBlur(240, 3, 8.0f)) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    return 0;
+}
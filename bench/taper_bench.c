@@ -0,0 +1,177 @@
+/*
+ iOS Knob Control
+ Copyright (c) 2013-14, Jimmy Dee
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Benchmark and accuracy check for IKCTaper.c. Runs anywhere with a C99 compiler and pthreads; see the Makefile.
+ *
+ * Reports the worst relative error of a 20 Hz-20 kHz logarithmic taper against pow(), the throughput of
+ * IKCTaperEvaluateBuffer and IKCSmootherProcess, and then runs a setter thread against a render thread to exercise
+ * the target handoff (build with make tsan to have ThreadSanitizer check it).
+ */
+
+// clock_gettime and CLOCK_MONOTONIC
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "IKCTaper.h"
+
+#define BUFFER_SIZE 4096
+#define RENDER_FRAMES 256
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// Accuracy
+
+static int checkLogarithmicTaper(void)
+{
+    static IKCTaper taper;
+    if (IKCTaperInit(&taper, IKCTaperLogarithmic, 20.0f, 20000.0f, 0.0f)) return -1;
+
+    double worst = 0.0;
+    int j;
+    for (j=0; j<=10000; ++j) {
+        double x = j / 10000.0;
+        double expected = 20.0 * pow(1000.0, x);
+        double error = fabs(IKCTaperEvaluate(&taper, x) - expected) / expected;
+        if (error > worst) worst = error;
+    }
+
+    printf("log taper:   worst relative error %.2e\n", worst);
+    return worst < 1e-4 ? 0 : -1;
+}
+
+static int checkSmootherRamp(void)
+{
+    IKCSmoother smoother;
+    float output[64];
+
+    IKCSmootherInit(&smoother, 0.0f, 100);
+    IKCSmootherSetTarget(&smoother, 1.0f);
+    IKCSmootherProcess(&smoother, output, 64);
+    if (fabsf(output[0] - 0.01f) > 1e-6f || fabsf(output[63] - 0.64f) > 1e-5f) return -1;
+
+    // the ramp lands exactly on the target and stays there
+    IKCSmootherProcess(&smoother, output, 64);
+    if (output[35] != 1.0f || output[63] != 1.0f) return -1;
+
+    printf("smoother:    ramp ok\n");
+    return 0;
+}
+
+// Throughput
+
+static void benchmarkTaper(void)
+{
+    static IKCTaper taper;
+    static float x[BUFFER_SIZE], values[BUFFER_SIZE];
+    const int repetitions = 20000;
+
+    IKCTaperInit(&taper, IKCTaperSCurve, 0.0f, 1.0f, 0.0f);
+
+    int j;
+    for (j=0; j<BUFFER_SIZE; ++j) {
+        x[j] = (float)j / (BUFFER_SIZE - 1);
+    }
+
+    double start = now();
+    for (j=0; j<repetitions; ++j) {
+        IKCTaperEvaluateBuffer(&taper, x, values, BUFFER_SIZE);
+        // keep the compiler from hoisting the call out of the loop
+        x[j % BUFFER_SIZE] += 0.0f * values[0];
+    }
+    double elapsed = now() - start;
+
+    printf("taper:       %.0f M samples/s\n", (double)BUFFER_SIZE * repetitions / elapsed / 1e6);
+}
+
+static void benchmarkSmoother(void)
+{
+    IKCSmoother smoother;
+    float output[RENDER_FRAMES];
+    const int buffers = 400000;
+    double sum = 0.0;
+
+    IKCSmootherInit(&smoother, 0.0f, 480);
+
+    double start = now();
+    int j;
+    for (j=0; j<buffers; ++j) {
+        if (j % 10 == 0) IKCSmootherSetTarget(&smoother, (j % 20) ? 1.0f : 0.0f);
+        IKCSmootherProcess(&smoother, output, RENDER_FRAMES);
+        sum += output[RENDER_FRAMES - 1];
+    }
+    double elapsed = now() - start;
+
+    printf("smoother:    %.0f M samples/s (checksum %g)\n", (double)RENDER_FRAMES * buffers / elapsed / 1e6, sum);
+}
+
+// Concurrent handoff
+
+static IKCSmoother sharedSmoother;
+
+static void* setterThread(void* context)
+{
+    int j;
+    for (j=0; j<1000000; ++j) {
+        IKCSmootherSetTarget(&sharedSmoother, (float)(j % 100) / 100.0f);
+    }
+    return context;
+}
+
+static int checkConcurrentHandoff(void)
+{
+    float output[RENDER_FRAMES];
+    pthread_t thread;
+
+    IKCSmootherInit(&sharedSmoother, 0.0f, 64);
+    if (pthread_create(&thread, NULL, setterThread, NULL)) return -1;
+
+    int j, k, failed = 0;
+    for (j=0; j<20000; ++j) {
+        IKCSmootherProcess(&sharedSmoother, output, RENDER_FRAMES);
+        // every target is in [0, 1), so every smoothed value must be too
+        for (k=0; k<RENDER_FRAMES; ++k) {
+            if (!(output[k] >= 0.0f && output[k] < 1.0f)) failed = 1;
+        }
+    }
+
+    pthread_join(thread, NULL);
+    printf("handoff:     %s\n", failed ? "FAILED" : "ok");
+    return failed ? -1 : 0;
+}
+
+int main(void)
+{
+    if (checkLogarithmicTaper() || checkSmootherRamp()) {
+        fprintf(stderr, "accuracy check failed\n");
+        return 1;
+    }
+
+    benchmarkTaper();
+    benchmarkSmoother();
+
+    return checkConcurrentHandoff() ? 1 : 0;
+}
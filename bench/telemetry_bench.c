@@ -0,0 +1,195 @@
+/*
+ iOS Knob Control
+ Copyright (c) 2013-14, Jimmy Dee
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * End-to-end benchmark for IKCTelemetry.c. Runs anywhere with a C99 compiler, BSD sockets and pthreads; see the Makefile.
+ *
+ * Runs an IKCTelemetryExporter against an IKCTelemetryReceiver in the same process, over UDP loopback and over a Unix-domain
+ * datagram socket, standing in for a knob on a device and a desktop audio engine. A producer thread pushes samples at a fixed
+ * rate, like knobs following gestures, or as fast as it can. The receiver reports samples/s, the latency from each sample's
+ * timestamp to its arrival, and how many samples the exporter dropped or the socket lost.
+ */
+
+// clock_gettime, nanosleep, getpid and CLOCK_MONOTONIC
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "IKCTelemetry.h"
+
+#define UDP_PORT 47613
+#define MAX_SAMPLES 200000
+
+typedef struct {
+    IKCTelemetryExporterRef exporter;
+    // samples per second, or 0 for as fast as possible
+    unsigned rate;
+    unsigned count;
+    int done;
+} Producer;
+
+static void* producerThread(void* context)
+{
+    Producer* producer = context;
+    IKCTelemetrySample sample;
+    memset(&sample, 0, sizeof(sample));
+    sample.phase = IKCTelemetryPhaseChanged;
+
+    uint64_t const start = IKCTelemetryTimestamp();
+    unsigned j;
+    for (j=0; j<producer->count; ++j) {
+        if (producer->rate > 0) {
+            // hold to the schedule without drifting: sleep until the time this sample is due
+            uint64_t const due = start + (uint64_t)j * 1000000000ull / producer->rate;
+            uint64_t const now = IKCTelemetryTimestamp();
+            if (due > now) {
+                struct timespec pause;
+                pause.tv_sec = (due - now) / 1000000000ull;
+                pause.tv_nsec = (due - now) % 1000000000ull;
+                nanosleep(&pause, NULL);
+            }
+        }
+
+        sample.knobID = j % 8;
+        sample.position = (float)j;
+        sample.positionIndex = (int32_t)j;
+        sample.timestamp = IKCTelemetryTimestamp();
+        IKCTelemetryExporterPush(producer->exporter, &sample);
+    }
+
+    IKCTelemetryExporterFlush(producer->exporter);
+    __atomic_store_n(&producer->done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static int compareLatencies(const void* a, const void* b)
+{
+    uint64_t const x = *(const uint64_t*)a;
+    uint64_t const y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+static int run(const char* name, const IKCTelemetryConfig* config, unsigned rate, unsigned count)
+{
+    static uint64_t latencies[MAX_SAMPLES];
+    IKCTelemetrySample samples[IKC_TELEMETRY_MAX_SAMPLES_PER_FRAME];
+
+    IKCTelemetryReceiverRef receiver = IKCTelemetryReceiverCreate(config);
+    if (!receiver) {
+        perror("IKCTelemetryReceiverCreate");
+        return -1;
+    }
+
+    IKCTelemetryExporterRef exporter = IKCTelemetryExporterCreate(config);
+    if (!exporter) {
+        perror("IKCTelemetryExporterCreate");
+        IKCTelemetryReceiverRelease(receiver);
+        return -1;
+    }
+
+    Producer producer;
+    producer.exporter = exporter;
+    producer.rate = rate;
+    producer.count = count;
+    producer.done = 0;
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, producerThread, &producer)) {
+        IKCTelemetryExporterRelease(exporter);
+        IKCTelemetryReceiverRelease(receiver);
+        return -1;
+    }
+
+    unsigned received = 0;
+    uint64_t first = 0, last = 0;
+    for (;;) {
+        // once the producer is done, anything still in flight arrives well within a flush interval
+        int const done = __atomic_load_n(&producer.done, __ATOMIC_ACQUIRE);
+        int n = IKCTelemetryReceiverReceive(receiver, samples, IKC_TELEMETRY_MAX_SAMPLES_PER_FRAME, done ? 100 : 1000);
+        if (n < 0) break;
+        if (n == 0) {
+            if (done) break;
+            continue;
+        }
+
+        uint64_t const now = IKCTelemetryTimestamp();
+        if (received == 0) first = now;
+        last = now;
+
+        int j;
+        for (j=0; j<n && received<MAX_SAMPLES; ++j) {
+            latencies[received++] = now - samples[j].timestamp;
+        }
+    }
+
+    pthread_join(thread, NULL);
+    uint64_t const dropped = IKCTelemetryExporterDroppedCount(exporter);
+    IKCTelemetryExporterRelease(exporter);
+    IKCTelemetryReceiverRelease(receiver);
+
+    char pace[32];
+    if (rate) snprintf(pace, sizeof(pace), "%u/s", rate);
+    else snprintf(pace, sizeof(pace), "unpaced");
+
+    if (received == 0) {
+        printf("%-5s %9s:  nothing received\n", name, pace);
+        return -1;
+    }
+
+    qsort(latencies, received, sizeof(latencies[0]), compareLatencies);
+    double const elapsed = (last - first) * 1e-9;
+    unsigned const lost = count - received - (unsigned)dropped;
+
+    printf("%-5s %9s:  %9.0f samples/s  latency p50 %7.3f ms p99 %7.3f ms  dropped %llu lost %u of %u\n", name, pace,
+           elapsed > 0.0 ? received / elapsed : 0.0, latencies[received / 2] * 1e-6, latencies[(size_t)(received * 0.99)] * 1e-6,
+           (unsigned long long)dropped, lost, count);
+    return 0;
+}
+
+int main(void)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/ikc_telemetry_bench.%ld", (long)getpid());
+
+    IKCTelemetryConfig udp;
+    memset(&udp, 0, sizeof(udp));
+    udp.transport = IKCTelemetryTransportUDP;
+    udp.host = "127.0.0.1";
+    udp.port = UDP_PORT;
+
+    IKCTelemetryConfig unixDomain;
+    memset(&unixDomain, 0, sizeof(unixDomain));
+    unixDomain.transport = IKCTelemetryTransportUnix;
+    unixDomain.path = path;
+
+    // 8 knobs followed at 120 Hz, a fast stream, then as fast as the producer can push
+    static const unsigned rates[] = { 960, 100000, 0 };
+    static const unsigned counts[] = { 2000, 100000, MAX_SAMPLES };
+
+    printf("default flush interval and threshold (10 ms, %d samples), capacity 1024\n", (int)IKC_TELEMETRY_MAX_SAMPLES_PER_FRAME);
+
+    size_t j;
+    for (j=0; j<sizeof(rates)/sizeof(rates[0]); ++j) {
+        if (run("udp", &udp, rates[j], counts[j]) || run("unix", &unixDomain, rates[j], counts[j])) return 1;
+    }
+    return 0;
+}